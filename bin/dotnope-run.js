@@ -15,7 +15,21 @@
 const { spawn } = require('child_process');
 const path = require('path');
 const fs = require('fs');
-const { generatePreloadEnv, findPreloadLibrary, isPreloadActive } = require('../lib/preload-generator');
+const {
+    generatePreloadEnv,
+    generateMinimalEnv,
+    compilePolicyFile,
+    readCompiledPolicy,
+    loadWhitelistConfig,
+    loadPublicVars,
+    publishPolicySegment,
+    readPreloadStats,
+    listPreloadStats,
+    findPreloadLibrary,
+    findPreloadLauncher,
+    generateLaunchCommand,
+    isPreloadActive
+} = require('../lib/preload-generator');
 
 // Parse arguments
 const args = process.argv.slice(2);
@@ -30,6 +44,14 @@ Usage:
   npx dotnope-run -- <command> [args...]   Run any command with protection
   npx dotnope-run --check                  Check if preload library is available
   npx dotnope-run --status                 Show current protection status
+  npx dotnope-run --compile-policy <file>  Compile the whitelist to a binary policy file
+  npx dotnope-run --stats <pid>            Show live preload counters of a process
+  npx dotnope-run --reload-policy <seg>    Publish the current whitelist to a running
+                                           policy segment (hot reload)
+  npx dotnope-run --print-launch <script.js|-- command> [args...]
+                                           Print a dotnope-launch command line that
+                                           execs the target directly (no resident
+                                           Node parent); combine with --policy-file
 
 Options:
   --help, -h      Show this help message
@@ -37,6 +59,19 @@ Options:
   --status        Show current protection status
   --verbose, -v   Show verbose output
   --log <file>    Log preload library activity to file
+  --policy-file <file>
+                  Compile the policy to <file> and pass it via DOTNOPE_POLICY_FILE
+                  instead of the DOTNOPE_POLICY string
+  --stats-dir <dir>
+                  Directory of preload counter regions (default /dev/shm)
+  --policy-shm <file>
+                  Publish the policy to a shared segment (e.g. /dev/shm/dotnope-app)
+                  and pass it via DOTNOPE_POLICY_SHM, so --reload-policy can
+                  update it without restarting the process
+  --minimal-env   Start the target with only the variables the whitelist allows
+                  (including publicVars), plus preload and Node runtime essentials
+  --keep <VAR[,VAR...]>
+                  Also keep these variables with --minimal-env (repeatable)
 
 Examples:
   npx dotnope-run server.js
@@ -53,6 +88,8 @@ if (args.includes('--check')) {
     const preloadPath = findPreloadLibrary();
     if (preloadPath) {
         console.log('[dotnope-run] Preload library found:', preloadPath);
+        const launcherPath = findPreloadLauncher();
+        console.log('[dotnope-run] Launcher:', launcherPath || '(not built)');
         process.exit(0);
     } else {
         console.error('[dotnope-run] Preload library NOT found!');
@@ -61,6 +98,54 @@ if (args.includes('--check')) {
     }
 }
 
+// Directory for preload counter regions (DOTNOPE_STATS)
+const statsDirIndex = args.indexOf('--stats-dir');
+const statsDir = statsDirIndex !== -1 && args[statsDirIndex + 1] ? args[statsDirIndex + 1] : undefined;
+
+// Stats command
+const statsIndex = args.indexOf('--stats');
+if (statsIndex !== -1) {
+    const pid = Number(args[statsIndex + 1]);
+    if (!Number.isInteger(pid) || pid <= 0) {
+        console.error('[dotnope-run] Error: --stats requires a process id');
+        process.exit(1);
+    }
+
+    let stats;
+    try {
+        stats = readPreloadStats(pid, statsDir);
+    } catch (err) {
+        console.error('[dotnope-run] Error:', err.message);
+        process.exit(1);
+    }
+
+    console.log(`[dotnope-run] Preload counters for pid ${stats.pid}:`);
+    for (const [op, counts] of Object.entries(stats.totals)) {
+        console.log(`  ${op.padEnd(10)} allowed ${String(counts.allowed).padStart(10)}  denied ${String(counts.denied).padStart(10)}`);
+    }
+    if (stats.dropped > 0) {
+        console.log(`  (${stats.dropped} events not attributed: counter table full)`);
+    }
+
+    const rows = Object.entries(stats.vars).map(([name, counts]) => {
+        const total = Object.values(counts).reduce((sum, c) => sum + c.allowed + c.denied, 0);
+        return { name, counts, total };
+    }).sort((a, b) => b.total - a.total);
+
+    console.log('');
+    console.log('  Variable / path                              allowed     denied   ops');
+    for (const row of rows) {
+        const allowed = Object.values(row.counts).reduce((sum, c) => sum + c.allowed, 0);
+        const denied = Object.values(row.counts).reduce((sum, c) => sum + c.denied, 0);
+        const ops = Object.entries(row.counts)
+            .filter(([, c]) => c.allowed + c.denied > 0)
+            .map(([op]) => op)
+            .join(',');
+        console.log(`  ${row.name.padEnd(42)} ${String(allowed).padStart(9)} ${String(denied).padStart(10)}   ${ops}`);
+    }
+    process.exit(0);
+}
+
 // Status command
 if (args.includes('--status')) {
     console.log('[dotnope-run] Protection Status:');
@@ -69,6 +154,22 @@ if (args.includes('--status')) {
     console.log('  Preload library:', findPreloadLibrary() || 'Not found');
     console.log('  Current LD_PRELOAD:', process.env.LD_PRELOAD || '(not set)');
     console.log('  Current DOTNOPE_POLICY:', process.env.DOTNOPE_POLICY || '(not set)');
+    console.log('  Current DOTNOPE_POLICY_FILE:', process.env.DOTNOPE_POLICY_FILE || '(not set)');
+    console.log('  Current DOTNOPE_POLICY_SHM:', process.env.DOTNOPE_POLICY_SHM || '(not set)');
+    if (process.env.DOTNOPE_POLICY_FILE) {
+        try {
+            const compiled = readCompiledPolicy(fs.readFileSync(process.env.DOTNOPE_POLICY_FILE));
+            console.log('  Policy file vars:', compiled.allowAll ? '* (allow all)' : compiled.vars.length);
+            console.log('  Policy file packages:', Object.keys(compiled.packages).length);
+        } catch (err) {
+            console.log('  Policy file error:', err.message);
+        }
+    }
+    const statsPids = listPreloadStats(statsDir);
+    console.log('  Processes publishing counters:', statsPids.length ? statsPids.join(', ') : '(none)');
+    if (statsPids.length) {
+        console.log('  (inspect with: npx dotnope-run --stats <pid>)');
+    }
     process.exit(0);
 }
 
@@ -82,6 +183,13 @@ if (process.platform !== 'linux') {
 // Parse flags
 let verbose = false;
 let logFile = null;
+let policyFile = null;
+let policySegment = null;
+let compileOnly = false;
+let reloadOnly = false;
+let printLaunch = false;
+let minimalEnv = false;
+const keepVars = [];
 const filteredArgs = [];
 
 for (let i = 0; i < args.length; i++) {
@@ -89,6 +197,24 @@ for (let i = 0; i < args.length; i++) {
         verbose = true;
     } else if (args[i] === '--log' && args[i + 1]) {
         logFile = args[++i];
+    } else if (args[i] === '--policy-file' && args[i + 1]) {
+        policyFile = args[++i];
+    } else if (args[i] === '--compile-policy' && args[i + 1]) {
+        policyFile = args[++i];
+        compileOnly = true;
+    } else if (args[i] === '--stats-dir' && args[i + 1]) {
+        i++;
+    } else if (args[i] === '--policy-shm' && args[i + 1]) {
+        policySegment = args[++i];
+    } else if (args[i] === '--reload-policy' && args[i + 1]) {
+        policySegment = args[++i];
+        reloadOnly = true;
+    } else if (args[i] === '--print-launch') {
+        printLaunch = true;
+    } else if (args[i] === '--minimal-env') {
+        minimalEnv = true;
+    } else if (args[i] === '--keep' && args[i + 1]) {
+        keepVars.push(...args[++i].split(',').filter(Boolean));
     } else if (args[i] === '--') {
         // Everything after -- is the command
         filteredArgs.push(...args.slice(i + 1));
@@ -98,7 +224,7 @@ for (let i = 0; i < args.length; i++) {
     }
 }
 
-if (filteredArgs.length === 0) {
+if (filteredArgs.length === 0 && !compileOnly && !reloadOnly) {
     console.error('[dotnope-run] Error: No script or command specified.');
     console.error('[dotnope-run] Run "npx dotnope-run --help" for usage.');
     process.exit(1);
@@ -124,10 +250,75 @@ if (!pkgPath) {
     process.exit(1);
 }
 
+// Compile command
+if (compileOnly) {
+    try {
+        const written = compilePolicyFile(pkgPath, policyFile);
+        console.log('[dotnope-run] Compiled policy written to:', written);
+        process.exit(0);
+    } catch (err) {
+        console.error('[dotnope-run] Error:', err.message);
+        process.exit(1);
+    }
+}
+
+// Reload command
+if (reloadOnly) {
+    try {
+        const generation = publishPolicySegment(policySegment, loadWhitelistConfig(pkgPath));
+        console.log(`[dotnope-run] Published policy generation ${generation} to:`, policySegment);
+        process.exit(0);
+    } catch (err) {
+        console.error('[dotnope-run] Error:', err.message);
+        process.exit(1);
+    }
+}
+
+/**
+ * Quote an argument for a POSIX shell
+ * @param {string} arg
+ * @returns {string}
+ */
+function shellQuote(arg) {
+    return /^[A-Za-z0-9_\/.,:=@%+-]+$/.test(arg) ? arg : `'${arg.replace(/'/g, `'\\''`)}'`;
+}
+
+/**
+ * Resolve the command to run: scripts run with the current node
+ * @param {string[]} argv - Target arguments
+ * @returns {string[]} Command followed by its arguments
+ */
+function resolveCommand(argv) {
+    if (argv[0].endsWith('.js') || argv[0].endsWith('.mjs') || argv[0].endsWith('.cjs')) {
+        return [process.execPath, ...argv];
+    }
+    return argv;
+}
+
+// Print-launch command
+if (printLaunch) {
+    if (minimalEnv) {
+        console.error('[dotnope-run] Error: --minimal-env only applies when dotnope-run starts the target.');
+        process.exit(1);
+    }
+    try {
+        const launch = generateLaunchCommand(pkgPath, resolveCommand(filteredArgs), {
+            policyFile,
+            policySegment,
+            logFile
+        });
+        console.log(launch.map(shellQuote).join(' '));
+        process.exit(0);
+    } catch (err) {
+        console.error('[dotnope-run] Error:', err.message);
+        process.exit(1);
+    }
+}
+
 // Generate preload environment
 let preloadEnv;
 try {
-    preloadEnv = generatePreloadEnv(pkgPath);
+    preloadEnv = generatePreloadEnv(pkgPath, { policyFile, policySegment });
 } catch (err) {
     console.error('[dotnope-run] Error:', err.message);
     process.exit(1);
@@ -138,36 +329,43 @@ if (logFile) {
     preloadEnv.DOTNOPE_LOG = logFile;
 }
 
+// Environment the target starts with
+const baseEnv = minimalEnv
+    ? generateMinimalEnv(loadWhitelistConfig(pkgPath), process.env, {
+        keep: keepVars,
+        publicVars: loadPublicVars(pkgPath)
+    })
+    : process.env;
+
 if (verbose) {
     console.log('[dotnope-run] Package.json:', pkgPath);
     console.log('[dotnope-run] LD_PRELOAD:', preloadEnv.LD_PRELOAD);
-    console.log('[dotnope-run] DOTNOPE_POLICY:', preloadEnv.DOTNOPE_POLICY || '(allow all)');
+    if (preloadEnv.DOTNOPE_POLICY_SHM) {
+        console.log('[dotnope-run] DOTNOPE_POLICY_SHM:', preloadEnv.DOTNOPE_POLICY_SHM);
+    } else if (preloadEnv.DOTNOPE_POLICY_FILE) {
+        console.log('[dotnope-run] DOTNOPE_POLICY_FILE:', preloadEnv.DOTNOPE_POLICY_FILE);
+    } else {
+        console.log('[dotnope-run] DOTNOPE_POLICY:', preloadEnv.DOTNOPE_POLICY || '(allow all)');
+    }
     if (logFile) {
         console.log('[dotnope-run] Logging to:', logFile);
     }
+    if (minimalEnv) {
+        console.log(`[dotnope-run] Minimal environment: ${Object.keys(baseEnv).length} of ` +
+            `${Object.keys(process.env).length} variables`);
+    }
     console.log('[dotnope-run] Running:', filteredArgs.join(' '));
     console.log('');
 }
 
-// Determine the command to run
-let command, commandArgs;
-
-// Check if first arg is a .js file
-if (filteredArgs[0].endsWith('.js') || filteredArgs[0].endsWith('.mjs') || filteredArgs[0].endsWith('.cjs')) {
-    // Run with node
-    command = process.execPath; // Use same node that's running this script
-    commandArgs = filteredArgs;
-} else {
-    // Run command directly
-    command = filteredArgs[0];
-    commandArgs = filteredArgs.slice(1);
-}
+// Determine the command to run (.js files run with the same node as this script)
+const [command, ...commandArgs] = resolveCommand(filteredArgs);
 
 // Spawn the process with preload environment
 const child = spawn(command, commandArgs, {
     stdio: 'inherit',
     env: {
-        ...process.env,
+        ...baseEnv,
         ...preloadEnv
     }
 });
@@ -5,7 +5,8 @@
             "native/src/dotnope_native.cc",
             "native/src/stack_trace.cc",
             "native/src/promise_hooks.cc",
-            "native/src/isolate_manager.cc"
+            "native/src/isolate_manager.cc",
+            "native/src/got_patcher.cc"
         ],
         "include_dirs": [
             "<!@(node -p \"require('node-addon-api').include\")",
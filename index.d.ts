@@ -41,6 +41,126 @@ export interface StrictEnvOptions {
      * Default is 5. Only applies if strictLoadOrder is true.
      */
     maxPreloadedModules?: number;
+
+    /**
+     * Patch the GOT of third-party native addons (.node files) as they load so
+     * their getenv/setenv/unsetenv/putenv and /proc/<pid>/environ opens follow
+     * their package's policy. Linux x86-64/AArch64 only; requires the native addon.
+     */
+    patchNativeAddons?: boolean;
+
+    /**
+     * Compile each package's CommonJS modules with their own `process`, whose
+     * env is bound to the package, so access is attributed without stack traces.
+     * The global process.env proxy still covers code outside the wrapper.
+     */
+    moduleScopedEnv?: boolean;
+
+    /**
+     * Record latency histograms for every access check (see getPerfStats()).
+     * Off by default: timing adds two clock reads per check.
+     */
+    perfStats?: boolean | PerfStatsOptions;
+
+    /**
+     * Serve reads from an in-memory snapshot of the environment instead of
+     * Node's env interceptor. Writes through process.env update it; changes
+     * made elsewhere (native setenv) need handle.resync(). Ignored on Windows.
+     */
+    envSnapshot?: boolean;
+}
+
+/**
+ * Settings for the perfStats option
+ */
+export interface PerfStatsOptions {
+    /** Keep checks slower than this in the slow-check log. Default 1. */
+    slowCheckThresholdMs?: number;
+    /** Number of slow checks kept, oldest dropped first. Default 64. */
+    slowCheckLogSize?: number;
+}
+
+/**
+ * Latency distribution of access checks, in nanoseconds
+ */
+export interface LatencySummary {
+    count: number;
+    min: number;
+    max: number;
+    mean: number;
+    stddev: number;
+    p50: number;
+    p90: number;
+    p99: number;
+    p999: number;
+}
+
+/**
+ * One access check that exceeded slowCheckThresholdMs
+ */
+export interface SlowCheck {
+    /** Timestamp (ms) when the check finished */
+    timestamp: number;
+    durationMs: number;
+    phases: { attribution: number; policy: number; report: number };
+    /** null when the caller could not be identified */
+    packageName: string | null;
+    envVar: string;
+    operation: 'read' | 'write' | 'delete';
+    /** Proxy trap of a read, or null */
+    trap: string | null;
+    allowed: boolean;
+    /** Caller location; null for module-scoped views, which skip the stack walk */
+    fileName: string | null;
+    lineNumber: number | null;
+    functionName: string | null;
+    isEval: boolean;
+    /** Stack at the end of the check */
+    stack: string;
+}
+
+/**
+ * Access check latencies recorded with the perfStats option
+ */
+export interface PerfStats {
+    /** Finding the caller, the policy verdict, and denial bookkeeping/error building */
+    phases: { attribution: LatencySummary; policy: LatencySummary; report: LatencySummary };
+    total: LatencySummary;
+    /** Whole-check latency by calling package */
+    packages: Record<string, LatencySummary>;
+    /** Oldest first */
+    slowChecks: SlowCheck[];
+}
+
+/**
+ * Counters for one patched native addon (path is null for calls that could
+ * not be attributed to a single addon)
+ */
+export interface NativePatchStats {
+    path: string | null;
+    slots: number;
+    allowed: number;
+    denied: number;
+}
+
+/**
+ * One denial, deduplicated per (package, var, operation): details of the
+ * first occurrence and the number of times it happened
+ */
+export interface DenialReport {
+    /** null when the caller could not be identified */
+    packageName: string | null;
+    envVar: string;
+    operation: 'read' | 'write' | 'delete';
+    code: DotnopeErrorCode;
+    count: number;
+    /** Timestamp (ms) of the first occurrence */
+    firstSeen: number;
+    fileName: string | null;
+    lineNumber: number | null;
+    functionName: string | null;
+    /** Error message the first occurrence produced */
+    message: string;
 }
 
 /**
@@ -62,6 +182,60 @@ export interface StrictEnvHandle {
      */
     getAccessStats(): Record<string, number>;
 
+    /**
+     * Get the access counts accumulated since the previous call (or since
+     * enabling), in the same key format as getAccessStats(). Each call
+     * advances the cursor, so successive deltas sum to the totals.
+     */
+    getAccessStatsDelta(): Record<string, number>;
+
+    /**
+     * Serialize the access counters in the Prometheus text exposition format.
+     * @param metricName - Defaults to "dotnope_env_access_total"
+     */
+    formatAccessStatsPrometheus(metricName?: string): string;
+
+    /**
+     * Get the number of accesses left out of the access counters because
+     * they already cover 4096 packages or 65536 variables.
+     */
+    getAccessStatsOverflow(): number;
+
+    /**
+     * Get denials, deduplicated per (package, var, operation).
+     */
+    getDenialReports(): DenialReport[];
+
+    /**
+     * Get the number of denials left out of getDenialReports() because
+     * reports already cover 4096 packages or 65536 (package, variable) pairs.
+     */
+    getDenialOverflow(): number;
+
+    /**
+     * Get access check latency histograms and the slow-check log.
+     * Returns null unless enabled with the perfStats option.
+     */
+    getPerfStats(): PerfStats | null;
+
+    /**
+     * Get allow/deny counters for native addons patched with patchNativeAddons.
+     * Returns null when the native addon is not available.
+     */
+    getNativePatchStats(): NativePatchStats[] | null;
+
+    /**
+     * Reload the envSnapshot from the real environment.
+     * Returns false without the envSnapshot option or once sealed.
+     */
+    resync(): boolean;
+
+    /**
+     * Make process.env read-only until disable(): writes, deletes and
+     * defines fail as on a frozen object (TypeError in strict mode).
+     */
+    seal(): void;
+
     /**
      * Get the security token required to disable protection.
      * Store this securely - any code with this token can disable protection!
@@ -97,6 +271,33 @@ export interface DotnopeGlobalOptions {
      * Packages only see env vars they have read permission for.
      */
     protectEnumeration?: boolean;
+
+    /**
+     * 'throw' (default): a denied access throws a StrictEnvError.
+     * 'silent': a denied read sees the variable as unset and a denied write
+     * or delete is dropped, without building an error; see getDenialReports().
+     */
+    denyMode?: 'throw' | 'silent';
+
+    /**
+     * Variables any package may read without attribution (no stack capture).
+     * Exact names or patterns such as "APP_*"; a pattern never covers a
+     * name that looks like a secret (KEY, TOKEN, PASSWORD, *_URL, ...).
+     * Writes and deletes are still checked.
+     */
+    publicVars?: string[];
+
+    /**
+     * If true, also treat well-known non-secret variables (NODE_ENV, TZ,
+     * DEBUG, LOG_LEVEL, LC_*, CI, ...) as public. Default false.
+     */
+    autoPublicVars?: boolean;
+
+    /**
+     * Fraction (0 to 1) of public reads that are still attributed and
+     * counted in getAccessStats(), for auditing. Default 0.
+     */
+    publicAuditRate?: number;
 }
 
 /**
@@ -105,19 +306,22 @@ export interface DotnopeGlobalOptions {
 export interface PackageEnvConfig {
     /**
      * List of allowed environment variable names for reading.
-     * Use "*" to allow read access to all environment variables.
+     * Use "*" to allow read access to all environment variables, or a
+     * pattern such as "OTEL_*" or "*_PROXY" ('*' matches any characters).
      */
     allowed: string[];
 
     /**
      * List of environment variable names the package can write/set.
      * Use "*" to allow write access to all environment variables.
+     * Patterns are accepted as in allowed.
      */
     canWrite?: string[];
 
     /**
      * List of environment variable names the package can delete.
      * Use "*" to allow delete access to all environment variables.
+     * Patterns are accepted as in allowed.
      */
     canDelete?: string[];
 
@@ -272,6 +476,27 @@ export function disableStrictEnv(): void;
  */
 export function getAccessStats(): Record<string, number>;
 
+/**
+ * Get the access counts accumulated since the previous call.
+ *
+ * @returns Object mapping "packageName:envVar:operation" to the count increment
+ */
+export function getAccessStatsDelta(): Record<string, number>;
+
+/**
+ * Serialize the access counters in the Prometheus text exposition format.
+ *
+ * @param metricName - Defaults to "dotnope_env_access_total"
+ */
+export function formatAccessStatsPrometheus(metricName?: string): string;
+
+/**
+ * Get access check latencies recorded with the perfStats option.
+ *
+ * @returns Histogram summaries and slow checks, or null when perfStats is off
+ */
+export function getPerfStats(): PerfStats | null;
+
 /**
  * Check if strict mode is currently enabled.
  *
@@ -314,6 +539,7 @@ export function isWorkerAllowed(): boolean;
 /**
  * Get a serializable copy of the current configuration.
  * Use this to pass config from main thread to worker threads.
+ * It carries the compiled policy as well, which the worker adopts as is.
  *
  * @returns Serializable config object to pass via workerData
  *
@@ -343,6 +569,9 @@ declare const _default: {
     enableStrictEnv: typeof enableStrictEnv;
     disableStrictEnv: typeof disableStrictEnv;
     getAccessStats: typeof getAccessStats;
+    getAccessStatsDelta: typeof getAccessStatsDelta;
+    formatAccessStatsPrometheus: typeof formatAccessStatsPrometheus;
+    getPerfStats: typeof getPerfStats;
     isEnabled: typeof isEnabled;
     isPreloadActive: typeof isPreloadActive;
     emitSecurityWarnings: typeof emitSecurityWarnings;
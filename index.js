@@ -4,6 +4,9 @@ const {
     enableStrictEnv,
     disableStrictEnv,
     getAccessStats,
+    getAccessStatsDelta,
+    formatAccessStatsPrometheus,
+    getPerfStats,
     isEnabled,
     isPreloadActive,
     emitSecurityWarnings,
@@ -16,6 +19,9 @@ module.exports = {
     enableStrictEnv,
     disableStrictEnv,
     getAccessStats,
+    getAccessStatsDelta,
+    formatAccessStatsPrometheus,
+    getPerfStats,
     isEnabled,
     isPreloadActive,
     emitSecurityWarnings,
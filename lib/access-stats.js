@@ -0,0 +1,237 @@
+/**
+ * access-stats.js - Per (package, variable, operation) access counters
+ *
+ * Package and variable names are interned to small integer ids; each package
+ * owns a row of Float64Array counters indexed by (varId << 2 | operation), so
+ * counting an access is two Map lookups and an increment with no string
+ * building. Slots touched since the last delta export are queued once per
+ * export, so getDelta() costs O(changed slots) rather than O(all slots).
+ */
+
+'use strict';
+
+const OPERATIONS = ['read', 'write', 'delete'];
+const OPERATION_INDEX = { read: 0, write: 1, delete: 2 };
+
+// Bounded interning, as in decision-cache.js; beyond these, accesses are
+// only counted in a single overflow counter, so a package probing random
+// names cannot grow memory without limit
+const MAX_PACKAGES = 4096;
+const MAX_VARS = 65536;
+const INITIAL_ROW_VARS = 64;
+
+const packageIds = new Map();
+const packageNames = [];
+const varIds = new Map();
+const varNames = [];
+
+// Per-package rows: { counts, reported, marks }, indexed by package id
+//   counts   - total accesses
+//   reported - total at the last getDelta()
+//   marks    - export generation in which the slot was last queued
+const rows = [];
+
+// Slots changed since the last getDelta(), as parallel (packageId, index) lists
+const dirtyPackages = [];
+const dirtyIndices = [];
+let generation = 1;
+
+// Accesses past the interning caps
+let overflow = 0;
+
+/**
+ * Intern a name
+ * @param {Map<string, number>} ids
+ * @param {string[]} names
+ * @param {string} name
+ * @param {number} limit
+ * @returns {number} Id, or -1 when the table is full
+ */
+function intern(ids, names, name, limit) {
+    let id = ids.get(name);
+    if (id === undefined) {
+        if (names.length >= limit) {
+            return -1;
+        }
+        id = names.length;
+        ids.set(name, id);
+        names.push(name);
+    }
+    return id;
+}
+
+/**
+ * Row of a package, grown to hold varId
+ * @param {number} packageId
+ * @param {number} varId
+ * @returns {Object}
+ */
+function rowFor(packageId, varId) {
+    let row = rows[packageId];
+    const needed = (varId + 1) << 2;
+
+    if (row === undefined || row.counts.length < needed) {
+        let length = row === undefined ? INITIAL_ROW_VARS << 2 : row.counts.length;
+        while (length < needed) {
+            length <<= 1;
+        }
+        const grown = {
+            counts: new Float64Array(length),
+            reported: new Float64Array(length),
+            marks: new Uint32Array(length)
+        };
+        if (row !== undefined) {
+            grown.counts.set(row.counts);
+            grown.reported.set(row.reported);
+            grown.marks.set(row.marks);
+        }
+        rows[packageId] = grown;
+        row = grown;
+    }
+    return row;
+}
+
+/**
+ * Count one access
+ * @param {string} packageName
+ * @param {string} envVar
+ * @param {string} operation - 'read', 'write' or 'delete'
+ */
+function record(packageName, envVar, operation) {
+    const op = OPERATION_INDEX[operation];
+    const packageId = intern(packageIds, packageNames, packageName, MAX_PACKAGES);
+    const varId = intern(varIds, varNames, envVar, MAX_VARS);
+
+    if (op === undefined || packageId < 0 || varId < 0) {
+        overflow++;
+        return;
+    }
+
+    const row = rowFor(packageId, varId);
+    const index = (varId << 2) | op;
+    row.counts[index]++;
+
+    if (row.marks[index] !== generation) {
+        row.marks[index] = generation;
+        dirtyPackages.push(packageId);
+        dirtyIndices.push(index);
+    }
+}
+
+/**
+ * Call fn(packageName, envVar, operation, count) for every counter
+ * @param {Function} fn
+ */
+function forEachSlot(fn) {
+    for (let packageId = 0; packageId < rows.length; packageId++) {
+        const row = rows[packageId];
+        if (row === undefined) {
+            continue;
+        }
+        const counts = row.counts;
+        for (let index = 0; index < counts.length; index++) {
+            if (counts[index] > 0) {
+                fn(packageNames[packageId], varNames[index >> 2], OPERATIONS[index & 3], counts[index]);
+            }
+        }
+    }
+}
+
+/**
+ * Get all counters
+ * @returns {Object} Access counts by "packageName:envVar:operation"
+ */
+function getSnapshot() {
+    const result = {};
+    forEachSlot((packageName, envVar, operation, count) => {
+        result[`${packageName}:${envVar}:${operation}`] = count;
+    });
+    return result;
+}
+
+/**
+ * Get the accesses counted since the previous call, and advance the cursor
+ * @returns {Object} Access count increments by "packageName:envVar:operation"
+ */
+function getDelta() {
+    const result = {};
+
+    for (let i = 0; i < dirtyPackages.length; i++) {
+        const packageId = dirtyPackages[i];
+        const index = dirtyIndices[i];
+        const row = rows[packageId];
+        const delta = row.counts[index] - row.reported[index];
+        if (delta > 0) {
+            result[`${packageNames[packageId]}:${varNames[index >> 2]}:${OPERATIONS[index & 3]}`] = delta;
+            row.reported[index] = row.counts[index];
+        }
+    }
+    dirtyPackages.length = 0;
+    dirtyIndices.length = 0;
+    generation++;
+
+    return result;
+}
+
+/**
+ * Get the number of accesses not counted per name because the package or
+ * variable caps were reached
+ * @returns {number}
+ */
+function getOverflow() {
+    return overflow;
+}
+
+/**
+ * Escape a Prometheus label value
+ * @param {string} value
+ * @returns {string}
+ */
+function escapeLabel(value) {
+    return String(value).replace(/\\/g, '\\\\').replace(/"/g, '\\"').replace(/\n/g, '\\n');
+}
+
+/**
+ * Serialize all counters in the Prometheus text exposition format
+ * @param {string} [metricName] - Defaults to dotnope_env_access_total
+ * @returns {string}
+ */
+function formatPrometheus(metricName = 'dotnope_env_access_total') {
+    const lines = [
+        `# HELP ${metricName} Environment variable accesses by package, variable and operation.`,
+        `# TYPE ${metricName} counter`
+    ];
+    const sample = (packageName, envVar, operation, count) => {
+        lines.push(
+            `${metricName}{package="${escapeLabel(packageName)}",variable="${escapeLabel(envVar)}",` +
+            `operation="${escapeLabel(operation)}"} ${count}`
+        );
+    };
+
+    forEachSlot(sample);
+    return lines.join('\n') + '\n';
+}
+
+/**
+ * Drop all counters and interned names
+ */
+function clear() {
+    packageIds.clear();
+    packageNames.length = 0;
+    varIds.clear();
+    varNames.length = 0;
+    rows.length = 0;
+    dirtyPackages.length = 0;
+    dirtyIndices.length = 0;
+    generation = 1;
+    overflow = 0;
+}
+
+module.exports = {
+    record,
+    getSnapshot,
+    getDelta,
+    getOverflow,
+    formatPrometheus,
+    clear
+};
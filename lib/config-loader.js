@@ -2,11 +2,17 @@
 
 const fs = require('fs');
 const path = require('path');
+const { compilePolicy, freezePolicy, isCompiledPolicy } = require('./policy-compiler');
 
 let cachedConfig = null;
 let cachedOptions = null;
+let cachedPolicy = null;
 let configPath = null;
 
+// Bumped whenever the active policy changes; verdicts cached under an older
+// epoch are stale (see decision-cache.js). Starts at 1 so 0 can mean "empty".
+let policyEpoch = 1;
+
 /**
  * Default options for dotnope behavior
  */
@@ -14,9 +20,15 @@ const DEFAULT_OPTIONS = {
     failClosed: true,           // Deny access when caller cannot be determined
     protectWrites: true,        // Control write operations to process.env
     protectDeletes: true,       // Control delete operations on process.env
-    protectEnumeration: true    // Filter ownKeys to only show allowed vars
+    protectEnumeration: true,   // Filter ownKeys to only show allowed vars
+    denyMode: 'throw',          // 'throw' an error on denial, or deny 'silent'ly
+    publicVars: [],             // Names/patterns anyone may read, without attribution
+    autoPublicVars: false,      // Also treat well-known non-secret vars (NODE_ENV, TZ, ...) as public
+    publicAuditRate: 0          // Fraction of public reads still attributed, for getAccessStats()
 };
 
+const DENY_MODES = ['throw', 'silent'];
+
 /**
  * Find package.json by walking up from a starting directory
  * @param {string} startDir - Directory to start searching from
@@ -51,11 +63,21 @@ function findPackageJson(startDir = process.cwd()) {
 function loadConfig(customPath = null, directConfig = null) {
     // If direct config is provided (e.g., for worker threads), use it
     if (directConfig && typeof directConfig === 'object') {
-        const whitelist = directConfig.environmentWhitelist || directConfig;
-        const { config, options } = normalizeConfig(whitelist);
-        cachedConfig = config;
-        cachedOptions = options;
+        if (isCompiledPolicy(directConfig.policy) && directConfig.config && typeof directConfig.config === 'object') {
+            // getSerializableConfig() output: already normalized and compiled,
+            // so peer dependencies are not resolved again
+            cachedConfig = directConfig.config;
+            cachedOptions = normalizeOptions(directConfig.options);
+            cachedPolicy = freezePolicy(directConfig.policy);
+        } else {
+            const whitelist = directConfig.environmentWhitelist || directConfig;
+            const { config, options, policy } = normalizeConfig(whitelist);
+            cachedConfig = config;
+            cachedOptions = options;
+            cachedPolicy = policy;
+        }
         configPath = '<worker:direct>';
+        policyEpoch++;
         return cachedConfig;
     }
 
@@ -74,9 +96,11 @@ function loadConfig(customPath = null, directConfig = null) {
         const whitelist = pkg.environmentWhitelist || {};
 
         // Normalize and validate configuration
-        const { config, options } = normalizeConfig(whitelist);
+        const { config, options, policy } = normalizeConfig(whitelist);
         cachedConfig = config;
         cachedOptions = options;
+        cachedPolicy = policy;
+        policyEpoch++;
 
         return cachedConfig;
     } catch (err) {
@@ -97,15 +121,40 @@ function loadConfig(customPath = null, directConfig = null) {
 function getSerializableConfig() {
     return {
         config: cachedConfig,
-        options: cachedOptions
+        options: cachedOptions,
+        policy: cachedPolicy
+    };
+}
+
+/**
+ * Normalize the __options__ entry
+ * @param {*} raw - Value of __options__
+ * @returns {Object} Options with defaults applied
+ */
+function normalizeOptions(raw) {
+    if (typeof raw !== 'object' || raw === null || Array.isArray(raw)) {
+        return { ...DEFAULT_OPTIONS };
+    }
+    return {
+        failClosed: raw.failClosed !== false,  // Default true
+        protectWrites: raw.protectWrites !== false,  // Default true
+        protectDeletes: raw.protectDeletes !== false,  // Default true
+        protectEnumeration: raw.protectEnumeration !== false,  // Default true
+        denyMode: DENY_MODES.includes(raw.denyMode) ? raw.denyMode : 'throw',
+        publicVars: Array.isArray(raw.publicVars) ? raw.publicVars.filter(name => typeof name === 'string') : [],
+        autoPublicVars: raw.autoPublicVars === true,
+        publicAuditRate: typeof raw.publicAuditRate === 'number' && raw.publicAuditRate >= 0 && raw.publicAuditRate <= 1
+            ? raw.publicAuditRate
+            : 0
     };
 }
 
 /**
  * Normalize whitelist configuration to a consistent format
- * Extracts __options__ into separate options object
+ * Extracts __options__ into separate options object and compiles the
+ * per-package entries into a lookup policy (see policy-compiler.js)
  * @param {Object} whitelist - Raw whitelist from package.json
- * @returns {Object} Object with { config, options }
+ * @returns {Object} Object with { config, options, policy }
  */
 function normalizeConfig(whitelist) {
     const normalized = {};
@@ -114,14 +163,7 @@ function normalizeConfig(whitelist) {
     for (const [packageName, config] of Object.entries(whitelist)) {
         // Handle __options__ special key
         if (packageName === '__options__') {
-            if (typeof config === 'object' && config !== null && !Array.isArray(config)) {
-                options = {
-                    failClosed: config.failClosed !== false,  // Default true
-                    protectWrites: config.protectWrites !== false,  // Default true
-                    protectDeletes: config.protectDeletes !== false,  // Default true
-                    protectEnumeration: config.protectEnumeration !== false  // Default true
-                };
-            }
+            options = normalizeOptions(config);
             continue;
         }
 
@@ -159,7 +201,7 @@ function normalizeConfig(whitelist) {
         // Skip invalid entries
     }
 
-    return { config: normalized, options };
+    return { config: normalized, options, policy: compilePolicy(normalized, options) };
 }
 
 /**
@@ -173,6 +215,17 @@ function getConfig() {
     return cachedConfig;
 }
 
+/**
+ * Get the compiled policy (loads config if not cached)
+ * @returns {Object} Policy for policy-compiler isAllowed()
+ */
+function getPolicy() {
+    if (!cachedPolicy) {
+        loadConfig();
+    }
+    return cachedPolicy;
+}
+
 /**
  * Get the current options (loads config if not cached)
  * @returns {Object} Options configuration
@@ -198,7 +251,17 @@ function getConfigPath() {
 function clearCache() {
     cachedConfig = null;
     cachedOptions = null;
+    cachedPolicy = null;
     configPath = null;
+    policyEpoch++;
+}
+
+/**
+ * Get the current policy epoch
+ * @returns {number} Counter that changes whenever the configuration does
+ */
+function getPolicyEpoch() {
+    return policyEpoch;
 }
 
 /**
@@ -236,9 +299,11 @@ module.exports = {
     loadConfig,
     getConfig,
     getOptions,
+    getPolicy,
     getConfigPath,
     clearCache,
     reloadConfig,
+    getPolicyEpoch,
     hasWhitelistEntry,
     getAllowedForPackage,
     normalizeConfig,
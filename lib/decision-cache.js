@@ -0,0 +1,131 @@
+/**
+ * decision-cache.js - Dense cache of policy verdicts
+ *
+ * Package names and environment variable names are interned to small integer
+ * ids. Each package owns a Uint32Array row indexed by (varId << 2 | operation);
+ * an entry holds (epoch << 1 | allowed), so a verdict is valid only for the
+ * policy epoch it was computed under (see config-loader getPolicyEpoch) and
+ * a reload or disable invalidates every entry at once without touching them.
+ * A zero entry is empty: epochs start at 1.
+ */
+
+'use strict';
+
+const OPERATION_INDEX = { read: 0, write: 1, delete: 2 };
+
+// Interning is bounded so that probing with arbitrary names cannot grow
+// memory without limit; beyond these, verdicts are simply not cached
+const MAX_PACKAGES = 4096;
+const MAX_VARS = 65536;
+const INITIAL_ROW_VARS = 64;
+
+// packageName -> id, envVar -> id
+const packageIds = new Map();
+const varIds = new Map();
+
+// Per-package verdict rows, indexed by package id
+const rows = [];
+
+/**
+ * Intern a name
+ * @param {Map<string, number>} ids
+ * @param {string} name
+ * @param {number} limit
+ * @returns {number} Id, or -1 when the table is full
+ */
+function intern(ids, name, limit) {
+    let id = ids.get(name);
+    if (id === undefined) {
+        if (ids.size >= limit) {
+            return -1;
+        }
+        id = ids.size;
+        ids.set(name, id);
+    }
+    return id;
+}
+
+/**
+ * Row of a package, grown to hold varId
+ * @param {number} packageId
+ * @param {number} varId
+ * @returns {Uint32Array}
+ */
+function rowFor(packageId, varId) {
+    let row = rows[packageId];
+    const needed = (varId + 1) << 2;
+
+    if (row === undefined || row.length < needed) {
+        let length = row === undefined ? INITIAL_ROW_VARS << 2 : row.length;
+        while (length < needed) {
+            length <<= 1;
+        }
+        const grown = new Uint32Array(length);
+        if (row !== undefined) {
+            grown.set(row);
+        }
+        rows[packageId] = grown;
+        row = grown;
+    }
+    return row;
+}
+
+/**
+ * Get a cached verdict, computing and storing it on a miss
+ * @param {string} packageName
+ * @param {string} envVar
+ * @param {string} operation - 'read', 'write' or 'delete'
+ * @param {number} epoch - Current policy epoch (>= 1)
+ * @param {Function} evaluate - (packageName, envVar, operation) => boolean
+ * @returns {boolean} Whether the access is allowed
+ */
+function decide(packageName, envVar, operation, epoch, evaluate) {
+    const op = OPERATION_INDEX[operation];
+    const packageId = intern(packageIds, packageName, MAX_PACKAGES);
+    const varId = intern(varIds, envVar, MAX_VARS);
+
+    if (op === undefined || packageId < 0 || varId < 0) {
+        return evaluate(packageName, envVar, operation);
+    }
+
+    const row = rowFor(packageId, varId);
+    const index = (varId << 2) | op;
+    const entry = row[index];
+
+    if (entry >>> 1 === epoch) {
+        return (entry & 1) === 1;
+    }
+
+    const allowed = evaluate(packageName, envVar, operation);
+    row[index] = ((epoch << 1) | (allowed ? 1 : 0)) >>> 0;
+    return allowed;
+}
+
+/**
+ * Drop all interned ids and rows
+ */
+function clear() {
+    packageIds.clear();
+    varIds.clear();
+    rows.length = 0;
+}
+
+/**
+ * Get cache dimensions (for diagnostics and tests)
+ * @returns {Object} { packages, vars, bytes }
+ */
+function getStats() {
+    let bytes = 0;
+    for (const row of rows) {
+        if (row !== undefined) {
+            bytes += row.byteLength;
+        }
+    }
+    return { packages: packageIds.size, vars: varIds.size, bytes };
+}
+
+module.exports = {
+    decide,
+    clear,
+    getStats
+};
@@ -9,6 +9,9 @@ const dependencyCache = new Map();
 // Cache: envVar -> Set of packages allowed to access it
 const envVarAllowedCache = new Map();
 
+// Config the envVarAllowedCache entries were computed from
+let envVarCacheConfig = null;
+
 // Track warnings already emitted to avoid spam
 const peerDepWarningsEmitted = new Set();
 
@@ -148,7 +151,12 @@ function getDependenciesWithLimit(packageName, depthLimit, excludePackages = new
  * @returns {Set<string>} Set of allowed package names
  */
 function getAllowedPackagesForEnvVar(envVar, config) {
-    // Check cache first - config is loaded once at init and cleared on disable
+    // Check cache first - entries are dropped when a different (reloaded)
+    // config object is passed in
+    if (config !== envVarCacheConfig) {
+        envVarAllowedCache.clear();
+        envVarCacheConfig = config;
+    }
     if (envVarAllowedCache.has(envVar)) {
         return envVarAllowedCache.get(envVar);
     }
@@ -189,15 +197,7 @@ function getAllowedPackagesForEnvVar(envVar, config) {
 
                 // Log warning for sensitive env vars with deep propagation
                 if (depthLimit > 1 && !envVar.startsWith('NODE_') && !envVar.startsWith('npm_')) {
-                    // Only warn once per package/envVar combination
-                    const warnKey = `${packageName}:${envVar}`;
-                    if (!peerDepWarningsEmitted.has(warnKey)) {
-                        console.warn(`[dotnope] WARNING: "${packageName}" grants "${envVar}" access to ${deps.size} peer dependencies (depth=${depthLimit}).`);
-                        if (depthLimit > 2) {
-                            console.warn(`[dotnope] Consider reducing peerDepthLimit for better security.`);
-                        }
-                        peerDepWarningsEmitted.add(warnKey);
-                    }
+                    warnDeepPeerGrant(packageName, envVar, deps.size, depthLimit);
                 }
             }
         }
@@ -207,6 +207,26 @@ function getAllowedPackagesForEnvVar(envVar, config) {
     return allowedPackages;
 }
 
+/**
+ * Warn that a package passes an env var on to peers more than one level deep.
+ * Only warns once per package/envVar combination.
+ * @param {string} packageName
+ * @param {string} envVar
+ * @param {number} peerCount - Number of peers granted access
+ * @param {number} depthLimit
+ */
+function warnDeepPeerGrant(packageName, envVar, peerCount, depthLimit) {
+    const warnKey = `${packageName}:${envVar}`;
+    if (peerDepWarningsEmitted.has(warnKey)) {
+        return;
+    }
+    console.warn(`[dotnope] WARNING: "${packageName}" grants "${envVar}" access to ${peerCount} peer dependencies (depth=${depthLimit}).`);
+    if (depthLimit > 2) {
+        console.warn(`[dotnope] Consider reducing peerDepthLimit for better security.`);
+    }
+    peerDepWarningsEmitted.add(warnKey);
+}
+
 /**
  * Check if a package is allowed to access an env var
  * @param {string} packageName
@@ -230,6 +250,7 @@ function isPackageAllowed(packageName, envVar, config) {
 function clearCache() {
     dependencyCache.clear();
     envVarAllowedCache.clear();
+    envVarCacheConfig = null;
     peerDepWarningsEmitted.clear();
 }
 
@@ -264,5 +285,6 @@ module.exports = {
     isPackageAllowed,
     clearCache,
     getDependencyTree,
-    getDependenciesWithLimit
+    getDependenciesWithLimit,
+    warnDeepPeerGrant
 };
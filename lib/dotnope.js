@@ -1,11 +1,20 @@
 'use strict';
 
 const crypto = require('crypto');
-const { createEnvProxy, enable, disable, restore, setFilterKeysFn } = require('./proxy');
-const { getCallingPackage, wasTamperingDetected } = require('./stack-parser');
-const { loadConfig, getConfig, getOptions, clearCache: clearConfigCache, getSerializableConfig } = require('./config-loader');
-const { isPackageAllowed, clearCache: clearDepCache } = require('./dependency-resolver');
+const {
+    createEnvProxy, createScopedEnv, createScopedProcess, enable, disable, restore, setFilterKeysFn, getKeySetVersion,
+    enableSnapshot, resyncSnapshot, seal, listEnvKeys
+} = require('./proxy');
+const { getCallingPackage, wasTamperingDetected, extractPackageName } = require('./stack-parser');
+const { loadConfig, getConfig, getOptions, getPolicy, clearCache: clearConfigCache, getSerializableConfig, getPolicyEpoch } = require('./config-loader');
+const { clearCache: clearDepCache } = require('./dependency-resolver');
+const { isAllowed, isPublic, hasWildcard } = require('./policy-compiler');
+const decisionCache = require('./decision-cache');
+const accessStats = require('./access-stats');
+const perfStats = require('./perf-stats');
+const moduleScope = require('./module-scope');
 const nativeBridge = require('./native-bridge');
+const { ESSENTIAL_VARS } = require('./preload-generator');
 
 // Worker thread support
 let isMainThread = true;
@@ -22,8 +31,30 @@ let isInitialized = false;
 let disableToken = null;
 let globalHandle = null;
 
-// Access tracking: "packageName:envVar" -> count
-const accessCounts = new Map();
+// Enumeration results: packageName -> { epoch, version, keys }
+const filteredKeysCache = new Map();
+
+// Denials: packageName -> envVar -> [read, write, delete] report (see deny())
+const denialReports = new Map();
+const OPERATION_SLOTS = { read: 0, write: 1, delete: 2 };
+
+// Bounded like decision-cache.js, so a package probing random names cannot
+// grow memory without limit; denials past the caps are only counted
+const MAX_DENIAL_PACKAGES = 4096;
+const MAX_DENIAL_VARS = 65536;
+let denialReportVars = 0;
+let denialOverflow = 0;
+
+// Current enumeration: { callerInfo, keys, cursor, trap, verified }
+let enumerationToken = null;
+
+// Per-package process views handed to modules: packageName -> Proxy.
+// A null-prototype object rather than a Map, so no method module code can
+// replace (Map.prototype.set) ever sees a view
+let moduleProcessViews = Object.create(null);
+
+// Public-tier reads since the last audited one (__options__.publicAuditRate)
+let publicReadsSinceAudit = 0;
 
 // Track if security warnings have been emitted
 let securityWarningsEmitted = false;
@@ -31,161 +62,434 @@ let securityWarningsEmitted = false;
 // Track if this is a worker that was explicitly allowed
 let workerAllowed = false;
 
+/**
+ * Remember the caller of an enumeration so the per-key descriptor and get
+ * traps that follow it (spread, Object.entries, Object.assign) reuse one
+ * attribution. Those built-ins read each key as a descriptor immediately
+ * followed by a get; anything out of that order drops the token and falls
+ * back to a stack capture.
+ *
+ * The traps carry no frame, so a bare token would attribute to the
+ * enumerator whatever read comes next, including one made by another
+ * package after the enumerator returned. The first descriptor/get pair is
+ * therefore still captured and must come from the exact call site of the
+ * ownKeys call; only once one built-in is known to be stepping through the
+ * keys are the remaining reads attributed from the token. Object.keys and
+ * JSON.stringify read every descriptor first, so they never reach that
+ * point. The token is closed once every key has been read, and never
+ * outlives the current synchronous turn.
+ * @param {Object} callerInfo - Attribution of the ownKeys call
+ * @param {Array} keys - Keys returned to the caller
+ */
+function beginEnumeration(callerInfo, keys) {
+    if (keys.length === 0) {
+        enumerationToken = null;
+        return;
+    }
+    const token = { callerInfo, keys, cursor: 0, trap: 'descriptor', verified: false };
+    enumerationToken = token;
+    queueMicrotask(() => {
+        if (enumerationToken === token) {
+            enumerationToken = null;
+        }
+    });
+}
+
+/**
+ * Whether two attributions point at the same call site
+ * @param {Object|null} a
+ * @param {Object} b
+ * @returns {boolean}
+ */
+function sameCallSite(a, b) {
+    return a !== null &&
+        a.packageName === b.packageName &&
+        a.fileName === b.fileName &&
+        a.lineNumber === b.lineNumber &&
+        a.columnNumber === b.columnNumber;
+}
+
+/**
+ * Attribute a read trap, reusing the enumeration caller when the read is
+ * the next one the enumerating built-in would make
+ * @param {string} envVar
+ * @param {string|undefined} trap - 'descriptor' or 'get'
+ * @returns {Object|null} callerInfo, or null if the caller must capture it
+ */
+function consumeEnumeration(envVar, trap) {
+    const token = enumerationToken;
+    if (token === null || trap === undefined) {
+        return null;
+    }
+    if (trap !== token.trap || token.keys[token.cursor] !== envVar) {
+        enumerationToken = null;
+        return null;
+    }
+
+    let callerInfo = token.callerInfo;
+    if (!token.verified) {
+        callerInfo = getCallingPackage(0);
+        if (!sameCallSite(callerInfo, token.callerInfo)) {
+            enumerationToken = null;
+            return callerInfo;
+        }
+    }
+
+    if (trap === 'descriptor') {
+        token.trap = 'get';
+    } else {
+        token.verified = true;
+        token.trap = 'descriptor';
+        if (++token.cursor === token.keys.length) {
+            enumerationToken = null;
+        }
+    }
+    return callerInfo;
+}
+
+/**
+ * Build the error for an access whose caller cannot be determined
+ * @param {string} envVar
+ * @param {string} operation
+ * @returns {Error}
+ */
+function createUnknownCallerError(envVar, operation) {
+    const error = new Error(
+        `dotnope: Unable to identify calling package!\n` +
+        `\n` +
+        `  Attempted to ${operation}: "${envVar}"\n` +
+        `  Caller could not be determined from stack trace.\n` +
+        `\n` +
+        `This may happen with eval(), async contexts, or native addons.\n` +
+        `To allow unknown callers (less secure), add to your package.json:\n` +
+        `\n` +
+        `  "environmentWhitelist": {\n` +
+        `    "__options__": {\n` +
+        `      "failClosed": false\n` +
+        `    }\n` +
+        `  }\n`
+    );
+    error.code = 'ERR_DOTNOPE_UNKNOWN_CALLER';
+    error.envVar = envVar;
+    error.operation = operation;
+    return error;
+}
+
+/**
+ * Build the error for an access from eval() or new Function()
+ * @param {Object} callerInfo
+ * @param {string} envVar
+ * @param {string} operation
+ * @returns {Error}
+ */
+function createEvalContextError(callerInfo, envVar, operation) {
+    const { packageName, fileName, lineNumber } = callerInfo;
+    const error = new Error(
+        `dotnope: Environment variable access from eval context blocked!\n` +
+        `\n` +
+        `  Attempted to ${operation}: "${envVar}"\n` +
+        `  Access originated from eval() or new Function()\n` +
+        `  Detected package: "${packageName}"\n` +
+        `  Location: ${fileName}:${lineNumber}\n` +
+        `\n` +
+        `eval() and Function constructor can obscure the true caller.\n` +
+        `This is blocked by default for security. To allow (less secure):\n` +
+        `\n` +
+        `  "environmentWhitelist": {\n` +
+        `    "__options__": {\n` +
+        `      "failClosed": false\n` +
+        `    }\n` +
+        `  }\n`
+    );
+    error.code = 'ERR_DOTNOPE_EVAL_CONTEXT';
+    error.envVar = envVar;
+    error.operation = operation;
+    error.packageName = packageName;
+    error.fileName = fileName;
+    error.lineNumber = lineNumber;
+    return error;
+}
+
+/**
+ * Build the error for an access the policy does not allow
+ * @param {string} packageName
+ * @param {string} envVar
+ * @param {string} operation
+ * @param {Object|null} callerInfo - Location; captured from the stack when not given
+ * @returns {Error}
+ */
+function createUnauthorizedError(packageName, envVar, operation, callerInfo) {
+    const {
+        fileName = '<unknown>',
+        lineNumber = 0,
+        functionName = '<anonymous>'
+    } = callerInfo || getCallingPackage(0) || {};
+    const configKey = operation === 'write' ? 'canWrite' : operation === 'delete' ? 'canDelete' : 'allowed';
+    const operationVerb = operation === 'read' ? 'read' : operation === 'write' ? 'write to' : 'delete';
+    const error = new Error(
+        `dotnope: Unauthorized environment variable ${operation}!\n` +
+        `\n` +
+        `  Package: "${packageName}"\n` +
+        `  Attempted to ${operationVerb}: "${envVar}"\n` +
+        `  Location: ${fileName}:${lineNumber}\n` +
+        `  Function: ${functionName}\n` +
+        `\n` +
+        `To allow this access, add to your package.json:\n` +
+        `\n` +
+        `  "environmentWhitelist": {\n` +
+        `    "${packageName}": {\n` +
+        `      "${configKey}": ["${envVar}"]\n` +
+        `    }\n` +
+        `  }\n`
+    );
+
+    error.code = 'ERR_DOTNOPE_UNAUTHORIZED';
+    error.packageName = packageName;
+    error.envVar = envVar;
+    error.operation = operation;
+    error.fileName = fileName;
+    error.lineNumber = lineNumber;
+    error.functionName = functionName;
+    return error;
+}
+
+/**
+ * Record a denial and enforce it according to __options__.denyMode.
+ * Reports are deduplicated per (package, var, operation): the first
+ * occurrence builds the error once for its details, later ones only count,
+ * so in 'silent' mode a repeated denial allocates nothing. Past
+ * MAX_DENIAL_PACKAGES packages or MAX_DENIAL_VARS (package, var) pairs,
+ * new denials only bump denialOverflow.
+ * @param {string|null} packageName - null when the caller is unknown
+ * @param {string} envVar
+ * @param {string} operation
+ * @param {Function} createError - () => Error, called at most once per report in 'silent' mode
+ * @returns {boolean} false in 'silent' mode; throws in 'throw' mode
+ */
+function deny(packageName, envVar, operation, createError) {
+    const reportPackage = packageName === null ? '<unknown>' : packageName;
+    let byVar = denialReports.get(reportPackage);
+    if (!byVar) {
+        if (denialReports.size >= MAX_DENIAL_PACKAGES) {
+            return denyUnreported(createError);
+        }
+        byVar = new Map();
+        denialReports.set(reportPackage, byVar);
+    }
+    let byOperation = byVar.get(envVar);
+    if (!byOperation) {
+        if (denialReportVars >= MAX_DENIAL_VARS) {
+            return denyUnreported(createError);
+        }
+        byOperation = [null, null, null];
+        byVar.set(envVar, byOperation);
+        denialReportVars++;
+    }
+
+    const slot = OPERATION_SLOTS[operation] || 0;
+    let report = byOperation[slot];
+    let error = null;
+
+    if (report === null) {
+        error = createError();
+        report = {
+            packageName,
+            envVar,
+            operation,
+            code: error.code,
+            count: 0,
+            firstSeen: Date.now(),
+            fileName: error.fileName || null,
+            lineNumber: error.lineNumber || null,
+            functionName: error.functionName || null,
+            message: error.message
+        };
+        byOperation[slot] = report;
+    }
+    report.count++;
+
+    if (getOptions().denyMode === 'silent') {
+        return false;
+    }
+    throw error || createError();
+}
+
+/**
+ * Enforce a denial that no longer fits in the reports
+ * @param {Function} createError
+ * @returns {boolean} false in 'silent' mode; throws in 'throw' mode
+ */
+function denyUnreported(createError) {
+    denialOverflow++;
+    if (getOptions().denyMode === 'silent') {
+        return false;
+    }
+    throw createError();
+}
+
 /**
  * Check if a package is allowed to access an environment variable
- * Throws an error if access is denied
+ * Throws an error if access is denied (denyMode 'throw')
  * @param {string} envVar - The environment variable being accessed
  * @param {string} operation - The operation type: 'read', 'write', or 'delete'
+ * @param {string} [trap] - Proxy trap of a read ('get' or 'descriptor')
+ * @returns {boolean} true if allowed, false if denied in denyMode 'silent'
  */
-function checkAccess(envVar, operation = 'read') {
-    // Get the caller info - isInternalFile check handles skipping strictenv frames
-    const callerInfo = getCallingPackage(0);
+function checkAccess(envVar, operation = 'read', trap) {
+    // Public-tier reads skip attribution (__options__.publicVars)
+    if (operation === 'read' && isPublic(getPolicy(), envVar)) {
+        return allowPublicRead(envVar, trap, null);
+    }
+
+    if (!perfStats.begin()) {
+        return checkCallerAccess(envVar, operation, trap);
+    }
+
+    let allowed = false;
+    try {
+        allowed = checkCallerAccess(envVar, operation, trap);
+        return allowed;
+    } finally {
+        perfStats.end(envVar, operation, trap, allowed);
+    }
+}
+
+/**
+ * Allow a read of a public-tier variable without attributing it. Every
+ * (1 / publicAuditRate)-th public read is still attributed and counted in
+ * the access stats, so audits can see who reads public variables.
+ * @param {string} envVar
+ * @param {string|undefined} trap
+ * @param {string|null} packageName - Caller, when already known (module-scoped views)
+ * @returns {boolean} Always true
+ */
+function allowPublicRead(envVar, trap, packageName) {
+    // Keep an enumeration in step even though this read is not attributed
+    const callerInfo = packageName === null ? consumeEnumeration(envVar, trap) : null;
+
+    const rate = getOptions().publicAuditRate;
+    if (rate > 0 && ++publicReadsSinceAudit >= 1 / rate) {
+        publicReadsSinceAudit = 0;
+        if (packageName === null) {
+            const info = callerInfo || getCallingPackage(0);
+            packageName = info ? info.packageName : null;
+        }
+        if (packageName !== null && packageName !== '__main__') {
+            accessStats.record(packageName, envVar, 'read');
+        }
+    }
+    return true;
+}
+
+/**
+ * Attribute an access to the calling package and check it
+ * @param {string} envVar
+ * @param {string} operation
+ * @param {string} [trap]
+ * @returns {boolean} true if allowed, false if denied in denyMode 'silent'
+ */
+function checkCallerAccess(envVar, operation, trap) {
+    // Get the caller info - isInternalFile check handles skipping strictenv frames.
+    // Reads that are part of an enumeration reuse its attribution.
+    const callerInfo = consumeEnumeration(envVar, trap) || getCallingPackage(0);
     const options = getOptions();
 
     if (!callerInfo) {
+        perfStats.attribute(null, null);
         // Cannot determine caller - this can happen in some edge cases
         // Fail-closed by default (configurable)
         if (options.failClosed) {
-            const error = new Error(
-                `dotnope: Unable to identify calling package!\n` +
-                `\n` +
-                `  Attempted to ${operation}: "${envVar}"\n` +
-                `  Caller could not be determined from stack trace.\n` +
-                `\n` +
-                `This may happen with eval(), async contexts, or native addons.\n` +
-                `To allow unknown callers (less secure), add to your package.json:\n` +
-                `\n` +
-                `  "environmentWhitelist": {\n` +
-                `    "__options__": {\n` +
-                `      "failClosed": false\n` +
-                `    }\n` +
-                `  }\n`
-            );
-            error.code = 'ERR_DOTNOPE_UNKNOWN_CALLER';
-            error.envVar = envVar;
-            error.operation = operation;
-            throw error;
+            return deny(null, envVar, operation, () => createUnknownCallerError(envVar, operation));
         }
-        return;
+        return true;
     }
 
-    const { packageName, fileName, lineNumber, functionName, isEval } = callerInfo;
+    const { packageName, isEval } = callerInfo;
+    perfStats.attribute(packageName, callerInfo);
 
     // Block eval/Function contexts when failClosed is enabled
     // eval() and new Function() can be used to hide the true calling package
     if (isEval && options.failClosed) {
-        const error = new Error(
-            `dotnope: Environment variable access from eval context blocked!\n` +
-            `\n` +
-            `  Attempted to ${operation}: "${envVar}"\n` +
-            `  Access originated from eval() or new Function()\n` +
-            `  Detected package: "${packageName}"\n` +
-            `  Location: ${fileName}:${lineNumber}\n` +
-            `\n` +
-            `eval() and Function constructor can obscure the true caller.\n` +
-            `This is blocked by default for security. To allow (less secure):\n` +
-            `\n` +
-            `  "environmentWhitelist": {\n` +
-            `    "__options__": {\n` +
-            `      "failClosed": false\n` +
-            `    }\n` +
-            `  }\n`
-        );
-        error.code = 'ERR_DOTNOPE_EVAL_CONTEXT';
-        error.envVar = envVar;
-        error.operation = operation;
-        error.packageName = packageName;
-        error.fileName = fileName;
-        error.lineNumber = lineNumber;
-        throw error;
+        return deny(packageName, envVar, operation, () => createEvalContextError(callerInfo, envVar, operation));
     }
 
     // Main application always has access
     if (packageName === '__main__') {
-        return;
+        return true;
     }
 
-    const config = getConfig();
+    return checkPackageAccess(packageName, envVar, operation, callerInfo);
+}
 
+/**
+ * Check an access already attributed to a package (not __main__)
+ * Throws an error if access is denied (denyMode 'throw')
+ * @param {string} packageName - The calling package
+ * @param {string} envVar - The environment variable being accessed
+ * @param {string} operation - The operation type: 'read', 'write', or 'delete'
+ * @param {Object|null} callerInfo - Location for the error message; captured
+ *   from the stack on denial when not given
+ * @returns {boolean} true if allowed, false if denied in denyMode 'silent'
+ */
+function checkPackageAccess(packageName, envVar, operation, callerInfo) {
     // Track access
-    const trackingKey = `${packageName}:${envVar}:${operation}`;
-    accessCounts.set(trackingKey, (accessCounts.get(trackingKey) || 0) + 1);
-
-    // Check if access is allowed based on operation type
-    let isAllowed = false;
-    let configKey = 'allowed';
-
-    if (operation === 'read') {
-        isAllowed = isPackageAllowed(packageName, envVar, config);
-        configKey = 'allowed';
-    } else if (operation === 'write') {
-        isAllowed = isPackageAllowedForOperation(packageName, envVar, config, 'canWrite');
-        configKey = 'canWrite';
-    } else if (operation === 'delete') {
-        isAllowed = isPackageAllowedForOperation(packageName, envVar, config, 'canDelete');
-        configKey = 'canDelete';
-    }
-
-    if (!isAllowed) {
-        const operationVerb = operation === 'read' ? 'read' : operation === 'write' ? 'write to' : 'delete';
-        const error = new Error(
-            `dotnope: Unauthorized environment variable ${operation}!\n` +
-            `\n` +
-            `  Package: "${packageName}"\n` +
-            `  Attempted to ${operationVerb}: "${envVar}"\n` +
-            `  Location: ${fileName}:${lineNumber}\n` +
-            `  Function: ${functionName}\n` +
-            `\n` +
-            `To allow this access, add to your package.json:\n` +
-            `\n` +
-            `  "environmentWhitelist": {\n` +
-            `    "${packageName}": {\n` +
-            `      "${configKey}": ["${envVar}"]\n` +
-            `    }\n` +
-            `  }\n`
-        );
+    accessStats.record(packageName, envVar, operation);
 
-        error.code = 'ERR_DOTNOPE_UNAUTHORIZED';
-        error.packageName = packageName;
-        error.envVar = envVar;
-        error.operation = operation;
-        error.fileName = fileName;
-        error.lineNumber = lineNumber;
-        error.functionName = functionName;
-
-        throw error;
+    // Verdicts are cached per (package, var, operation) until the policy changes
+    const allowed = decisionCache.decide(packageName, envVar, operation, getPolicyEpoch(), evaluateAccess);
+    perfStats.mark(perfStats.PHASE_POLICY);
+    if (allowed) {
+        return true;
     }
+
+    return deny(packageName, envVar, operation,
+        () => createUnauthorizedError(packageName, envVar, operation, callerInfo));
 }
 
 /**
- * Check if a package is allowed for write/delete operations
+ * Check an access through a module-scoped env view (moduleScopedEnv),
+ * which is attributed to its package without a stack capture
  * @param {string} packageName
  * @param {string} envVar
- * @param {Object} config
- * @param {string} operationKey - 'canWrite' or 'canDelete'
- * @returns {boolean}
+ * @param {string} operation
+ * @returns {boolean} true if allowed, false if denied in denyMode 'silent'
  */
-function isPackageAllowedForOperation(packageName, envVar, config, operationKey) {
-    // Main application always has access
-    if (packageName === '__main__') {
-        return true;
+function checkScopedAccess(packageName, envVar, operation) {
+    if (operation === 'read' && isPublic(getPolicy(), envVar)) {
+        return allowPublicRead(envVar, undefined, packageName);
     }
 
-    const packageConfig = config[packageName];
-    if (!packageConfig) {
-        return false;
+    if (!perfStats.begin()) {
+        return checkPackageAccess(packageName, envVar, operation, null);
     }
 
-    const allowedVars = packageConfig[operationKey] || [];
-    return allowedVars.includes(envVar) || allowedVars.includes('*');
+    let allowed = false;
+    try {
+        perfStats.attribute(packageName, null);
+        allowed = checkPackageAccess(packageName, envVar, operation, null);
+        return allowed;
+    } finally {
+        perfStats.end(envVar, operation, undefined, allowed);
+    }
+}
+
+/**
+ * Evaluate the policy for one access, without caching
+ * @param {string} packageName
+ * @param {string} envVar
+ * @param {string} operation - 'read', 'write' or 'delete'
+ * @returns {boolean}
+ */
+function evaluateAccess(packageName, envVar, operation) {
+    return isAllowed(getPolicy(), packageName, envVar, operation);
 }
 
 /**
  * Filter ownKeys results based on caller's allowed env vars
- * @param {Array} allKeys - All environment variable keys
+ * @param {Function} listKeys - Returns every key of the environment
  * @returns {Array|null} Filtered keys or null to skip filtering
  */
-function filterKeys(allKeys) {
+function filterKeys(listKeys) {
     const callerInfo = getCallingPackage(0);
 
     // Can't determine caller - return null to skip filtering
@@ -196,33 +500,54 @@ function filterKeys(allKeys) {
         return options.failClosed ? [] : null;
     }
 
-    const { packageName } = callerInfo;
+    // Unfiltered (__main__, wildcard) enumerations get no token: it would
+    // hand their access to every key to whoever reads next
+    const keys = filterKeysForPackage(callerInfo.packageName, listKeys);
+    if (keys !== null) {
+        beginEnumeration(callerInfo, keys);
+    }
+    return keys;
+}
 
+/**
+ * Filter ownKeys results for a known package.
+ * The filtered array is cached per package and reused until a write or
+ * delete through process.env changes the key set, or the policy changes.
+ * @param {string} packageName
+ * @param {Function} listKeys - Returns every key of the environment
+ * @returns {Array|null} Filtered keys or null to skip filtering
+ */
+function filterKeysForPackage(packageName, listKeys) {
     // Main application sees everything
     if (packageName === '__main__') {
         return null; // Skip filtering
     }
 
-    const config = getConfig();
-    const packageConfig = config[packageName];
-
-    // Package not in whitelist - sees nothing
-    if (!packageConfig) {
-        return [];
+    const epoch = getPolicyEpoch();
+    const version = getKeySetVersion();
+    const cached = filteredKeysCache.get(packageName);
+    if (cached && cached.epoch === epoch && cached.version === version) {
+        return cached.keys;
     }
 
-    // Package has wildcard access - sees everything
-    if (packageConfig.allowed.includes('*')) {
-        return null; // Skip filtering
+    // Same compiled policy as reads, so peers granted a variable see it too
+    const policy = getPolicy();
+    let keys;
+
+    const listed = policy.packageIds.has(packageName);
+    if (listed && hasWildcard(policy, packageName, 'read')) {
+        // Package has wildcard access - sees everything
+        keys = null; // Skip filtering
+    } else {
+        // Filter to allowed and public keys; listed packages also keep
+        // symbols and non-string keys, others see only public variables
+        keys = listKeys().filter(key => typeof key === 'string'
+            ? isPublic(policy, key) || isAllowed(policy, packageName, key, 'read')
+            : listed);
     }
 
-    // Filter to only allowed keys (keep symbols and non-string keys)
-    return allKeys.filter(key => {
-        if (typeof key !== 'string') {
-            return true; // Keep symbols
-        }
-        return packageConfig.allowed.includes(key);
-    });
+    filteredKeysCache.set(packageName, { epoch, version, keys });
+    return keys;
 }
 
 /**
@@ -314,6 +639,70 @@ function emitSecurityWarnings(options = {}) {
     return warnings;
 }
 
+/**
+ * Get the process view injected into a CommonJS module (moduleScopedEnv).
+ * One view per package; its env checks are bound to that package, so no
+ * stack is captured. Application modules get the real process.
+ * @param {string} filename - Module being compiled
+ * @returns {Object|null} Process view, or null for the real process
+ */
+function getModuleProcess(filename) {
+    const packageName = extractPackageName(filename);
+    if (packageName === '__main__') {
+        return null;
+    }
+
+    let view = moduleProcessViews[packageName];
+    if (!view) {
+        const scopedEnv = createScopedEnv(
+            (envVar, operation) => checkScopedAccess(packageName, envVar, operation),
+            (listKeys) => filterKeysForPackage(packageName, listKeys)
+        );
+        view = createScopedProcess(scopedEnv);
+        moduleProcessViews[packageName] = view;
+    }
+    return view;
+}
+
+/**
+ * List the public tier as names for native code, which matches names only:
+ * explicit names, plus variables currently set that a public pattern covers
+ * @returns {string[]}
+ */
+function getPublicVarNames() {
+    const policy = getPolicy();
+    const names = new Set(policy.publicNames);
+    if (policy.publicPatterns.length > 0) {
+        for (const key of listEnvKeys()) {
+            if (typeof key === 'string' && isPublic(policy, key)) {
+                names.add(key);
+            }
+        }
+    }
+    return [...names];
+}
+
+/**
+ * Build the GOT patch policy for a native addon from its package's config.
+ * Application addons (__main__) are left unpatched.
+ * @param {string} filename - Path to the .node file
+ * @returns {Object|null} Policy for nativeBridge.patchNativeModule, or null
+ */
+function getNativeAddonPolicy(filename) {
+    const packageName = extractPackageName(filename);
+    if (packageName === '__main__') {
+        return null;
+    }
+
+    const entry = getConfig()[packageName];
+    return {
+        allowed: [...ESSENTIAL_VARS, ...getPublicVarNames(), ...(entry ? entry.allowed : [])],
+        canWrite: entry ? entry.canWrite : [],
+        canDelete: entry ? entry.canDelete : [],
+        protectProc: true
+    };
+}
+
 /**
  * Enable strict environment variable access control
  * @param {Object} options - Configuration options
@@ -322,6 +711,14 @@ function emitSecurityWarnings(options = {}) {
  * @param {boolean} [options.verbose] - Show all warnings including info level
  * @param {boolean} [options.allowInWorker] - Allow enabling in worker threads
  * @param {Object} [options.workerConfig] - Config passed from main thread
+ * @param {boolean} [options.patchNativeAddons] - Patch the GOT of third-party .node addons
+ *   so their getenv/setenv/open calls follow the package's policy (Linux, native addon required)
+ * @param {boolean} [options.moduleScopedEnv] - Give each package's CommonJS modules their own
+ *   `process` whose env is bound to the package, attributing access without stack traces
+ * @param {boolean|Object} [options.perfStats] - Record access check latency histograms;
+ *   an object may set slowCheckThresholdMs (default 1) and slowCheckLogSize (default 64)
+ * @param {boolean} [options.envSnapshot] - Serve reads from a snapshot of the environment
+ *   kept in sync with writes through process.env (see handle.resync() and handle.seal())
  * @returns {Object} Handle with token-protected disable() and getAccessStats() methods
  */
 function enableStrictEnv(options = {}) {
@@ -399,11 +796,39 @@ function enableStrictEnv(options = {}) {
         setFilterKeysFn(filterKeys);
     }
 
+    // Reads from a Map instead of Node's env interceptor; Windows env names
+    // are case-insensitive, which a Map cannot reproduce
+    if (options.envSnapshot) {
+        if (process.platform === 'win32') {
+            console.warn('[dotnope] envSnapshot is not supported on Windows; reading process.env directly.');
+        } else {
+            enableSnapshot();
+        }
+    }
+
     // Enable promise hooks for async context tracking (if native available)
     if (nativeBridge.isNativeAvailable()) {
         nativeBridge.enablePromiseHooks();
     }
 
+    // Interpose on native addons' libc env/file calls (no LD_PRELOAD needed)
+    if (options.patchNativeAddons) {
+        if (!nativeBridge.installDlopenHook(getNativeAddonPolicy)) {
+            console.warn('[dotnope] patchNativeAddons requires the native addon; native code is not filtered.');
+        }
+    }
+
+    // Attribute by module scope instead of stack walks; the global proxy
+    // remains for code that reaches process.env some other way
+    if (options.moduleScopedEnv) {
+        moduleScope.install(getModuleProcess);
+    }
+
+    // Opt-in timing of every check (see getPerfStats)
+    if (options.perfStats) {
+        perfStats.enable(typeof options.perfStats === 'object' ? options.perfStats : {});
+    }
+
     enable();
 
     isInitialized = true;
@@ -465,6 +890,54 @@ function createHandle() {
          * @returns {Object} Access counts by "packageName:envVar:operation"
          */
         getAccessStats: getAccessStats,
+        /**
+         * Get the accesses counted since the previous call
+         * @returns {Object} Increments by "packageName:envVar:operation"
+         */
+        getAccessStatsDelta: getAccessStatsDelta,
+        /**
+         * Get access counters as Prometheus text
+         * @returns {string}
+         */
+        formatAccessStatsPrometheus: formatAccessStatsPrometheus,
+        /**
+         * Get the number of accesses not counted per name because the
+         * package or variable caps were reached
+         * @returns {number}
+         */
+        getAccessStatsOverflow: getAccessStatsOverflow,
+        /**
+         * Get denials, deduplicated per (package, var, operation)
+         * @returns {Array} Reports with first-occurrence details and a count
+         */
+        getDenialReports: getDenialReports,
+        /**
+         * Get the number of denials not recorded in the reports because
+         * the package or variable caps were reached
+         * @returns {number}
+         */
+        getDenialOverflow: getDenialOverflow,
+        /**
+         * Get access check latency histograms and slow checks (perfStats)
+         * @returns {Object|null} Null unless enabled with perfStats
+         */
+        getPerfStats: getPerfStats,
+        /**
+         * Get counters for native addons patched via patchNativeAddons
+         * @returns {Array|null} [{ path, slots, allowed, denied }] or null
+         */
+        getNativePatchStats: () => nativeBridge.getNativePatchStats(),
+        /**
+         * Reload the envSnapshot from the real environment, picking up
+         * changes made outside process.env (e.g. setenv() in native code)
+         * @returns {boolean} false without envSnapshot or once sealed
+         */
+        resync: () => resyncSnapshot(),
+        /**
+         * Make process.env read-only until disable(): writes, deletes and
+         * defines fail as on a frozen object (TypeError in strict mode)
+         */
+        seal: () => seal(),
         /**
          * Get the disable token (store securely!)
          * @returns {string} The token required to disable protection
@@ -482,6 +955,12 @@ function disableStrictEnvInternal() {
     if (nativeBridge.isNativeAvailable()) {
         nativeBridge.disablePromiseHooks();
     }
+    nativeBridge.uninstallDlopenHook();
+    moduleScope.uninstall();
+    moduleProcessViews = Object.create(null);
+    filteredKeysCache.clear();
+    enumerationToken = null;
+    publicReadsSinceAudit = 0;
 
     disable();
     restore();
@@ -492,7 +971,12 @@ function disableStrictEnvInternal() {
     // Clear caches
     clearConfigCache();
     clearDepCache();
-    accessCounts.clear();
+    decisionCache.clear();
+    denialReports.clear();
+    denialReportVars = 0;
+    denialOverflow = 0;
+    accessStats.clear();
+    perfStats.disable();
 }
 
 /**
@@ -518,16 +1002,75 @@ function disableStrictEnv() {
 
 /**
  * Get access statistics
- * @returns {Object} Access counts by "packageName:envVar"
+ * @returns {Object} Access counts by "packageName:envVar:operation"
  */
 function getAccessStats() {
-    const result = {};
-    for (const [key, count] of accessCounts) {
-        result[key] = count;
+    return accessStats.getSnapshot();
+}
+
+/**
+ * Get the accesses counted since the previous call (one shared cursor)
+ * @returns {Object} Access count increments by "packageName:envVar:operation"
+ */
+function getAccessStatsDelta() {
+    return accessStats.getDelta();
+}
+
+/**
+ * Get access counters in the Prometheus text exposition format
+ * @param {string} [metricName] - Defaults to dotnope_env_access_total
+ * @returns {string}
+ */
+function formatAccessStatsPrometheus(metricName) {
+    return accessStats.formatPrometheus(metricName);
+}
+
+/**
+ * Get the number of accesses past the access counter caps
+ * @returns {number}
+ */
+function getAccessStatsOverflow() {
+    return accessStats.getOverflow();
+}
+
+/**
+ * Get deduplicated denial reports
+ * @returns {Array} [{ packageName, envVar, operation, code, count, firstSeen,
+ *   fileName, lineNumber, functionName, message }], first occurrence details
+ *   plus the number of times the denial happened
+ */
+function getDenialReports() {
+    const result = [];
+    for (const byVar of denialReports.values()) {
+        for (const byOperation of byVar.values()) {
+            for (const report of byOperation) {
+                if (report !== null) {
+                    result.push({ ...report });
+                }
+            }
+        }
     }
     return result;
 }
 
+/**
+ * Get the number of denials past the report caps
+ * @returns {number}
+ */
+function getDenialOverflow() {
+    return denialOverflow;
+}
+
+/**
+ * Get access check latencies recorded with the perfStats option
+ * @returns {Object|null} { phases: { attribution, policy, report }, total,
+ *   packages, slowChecks }; histogram summaries are in nanoseconds, or null
+ *   when perfStats is off
+ */
+function getPerfStats() {
+    return perfStats.getSnapshot();
+}
+
 /**
  * Check if strict mode is currently enabled
  * @returns {boolean}
@@ -540,6 +1083,9 @@ module.exports = {
     enableStrictEnv,
     disableStrictEnv,
     getAccessStats,
+    getAccessStatsDelta,
+    formatAccessStatsPrometheus,
+    getPerfStats,
     isEnabled,
     isPreloadActive,
     emitSecurityWarnings,
@@ -0,0 +1,152 @@
+/**
+ * env-pattern.js - Glob patterns over environment variable names
+ *
+ * A pattern is a whitelist entry containing '*', which matches any run of
+ * characters: OTEL_*, npm_config_*, *_PROXY. (A lone '*' is the existing
+ * allow-everything wildcard and is handled by the callers.)
+ *
+ * All patterns of a set are matched by one automaton. Its NFA states are
+ * (pattern, position) pairs; DFA states are sets of those, built lazily from
+ * the transitions names actually take and memoized, so after warm-up a name
+ * is matched in O(length) Map lookups regardless of how many patterns there
+ * are, and shared prefixes (AWS_*, AWS_SDK_*) cost nothing extra.
+ */
+
+'use strict';
+
+const STAR = 0x2a; // '*'
+
+// Bound on memoized DFA states; past it, new states are computed per match
+// rather than stored, which stays correct but loses the O(length) guarantee
+const MAX_DFA_STATES = 4096;
+
+const NO_MATCHES = Object.freeze([]);
+
+/**
+ * Check if a whitelist entry is a pattern (contains '*' but is not '*')
+ * @param {*} entry
+ * @returns {boolean}
+ */
+function isPattern(entry) {
+    return typeof entry === 'string' && entry !== '*' && entry.includes('*');
+}
+
+/**
+ * Compile patterns into a matcher
+ * @param {string[]} patterns
+ * @returns {Object} { match(name) } returning the indices (into patterns)
+ *   of every pattern the name matches, ascending; do not modify the result
+ */
+function createMatcher(patterns) {
+    // NFA state ids: offsets[p] + position in patterns[p]; position ===
+    // length is the accepting state of the pattern
+    const offsets = [];
+    const owners = [];
+    for (let p = 0; p < patterns.length; p++) {
+        offsets.push(owners.length);
+        for (let position = 0; position <= patterns[p].length; position++) {
+            owners.push(p);
+        }
+    }
+
+    /**
+     * Add a state and the states reachable by skipping '*' (matching nothing)
+     * @param {Set<number>} set
+     * @param {number} state
+     */
+    function addClosure(set, state) {
+        const p = owners[state];
+        const pattern = patterns[p];
+        let position = state - offsets[p];
+        set.add(state);
+        while (position < pattern.length && pattern.charCodeAt(position) === STAR) {
+            position++;
+            set.add(offsets[p] + position);
+        }
+    }
+
+    const dfaStates = new Map();
+
+    /**
+     * Get the DFA state for a set of NFA states
+     * @param {Set<number>} set
+     * @returns {Object} { nfa, accepts, next, stored }
+     */
+    function dfaState(set) {
+        const nfa = [...set].sort((a, b) => a - b);
+        const key = nfa.join(',');
+        let state = dfaStates.get(key);
+        if (state) {
+            return state;
+        }
+
+        const accepts = [];
+        for (const id of nfa) {
+            const p = owners[id];
+            if (id - offsets[p] === patterns[p].length) {
+                accepts.push(p);
+            }
+        }
+        state = {
+            nfa,
+            accepts: accepts.length > 0 ? accepts : NO_MATCHES,
+            next: new Map(),
+            stored: dfaStates.size < MAX_DFA_STATES
+        };
+        if (state.stored) {
+            dfaStates.set(key, state);
+        }
+        return state;
+    }
+
+    /**
+     * Compute the transition of a DFA state on one character
+     * @param {Object} state
+     * @param {number} code
+     * @returns {Object}
+     */
+    function step(state, code) {
+        const set = new Set();
+        for (const id of state.nfa) {
+            const p = owners[id];
+            const position = id - offsets[p];
+            if (position === patterns[p].length) {
+                continue;
+            }
+            const expected = patterns[p].charCodeAt(position);
+            if (expected === STAR) {
+                addClosure(set, id);
+            } else if (expected === code) {
+                addClosure(set, id + 1);
+            }
+        }
+
+        const next = dfaState(set);
+        if (next.stored) {
+            state.next.set(code, next);
+        }
+        return next;
+    }
+
+    const initial = new Set();
+    for (const offset of offsets) {
+        addClosure(initial, offset);
+    }
+    const start = dfaState(initial);
+
+    return {
+        match(name) {
+            let state = start;
+            for (let i = 0; i < name.length && state.nfa.length > 0; i++) {
+                const code = name.charCodeAt(i);
+                state = state.next.get(code) || step(state, code);
+            }
+            return state.accepts;
+        }
+    };
+}
+
+module.exports = {
+    isPattern,
+    createMatcher
+};
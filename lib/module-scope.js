@@ -0,0 +1,124 @@
+'use strict';
+
+/**
+ * module-scope.js - Per-module `process` injection through the CommonJS loader
+ *
+ * Module.wrap is replaced with a wrapper that adds a `process` parameter to
+ * every module function, and Module.prototype._compile is wrapped to decide
+ * which object that parameter receives. Code in a package then resolves the
+ * free identifier `process` to a view bound to its own package, so access
+ * checks need no stack capture. Code that escapes the wrapper (ESM,
+ * globalThis.process, vm contexts) still reaches the global process.env
+ * proxy.
+ *
+ * The view is handed over through a one-shot property on the Module object:
+ * _compile sets it right before the module function runs and the wrapper
+ * deletes it as its first action, so module code (which can reach other
+ * Module objects through require.cache) never finds a view waiting that is
+ * not its own.
+ *
+ * Module code runs between installs and can replace globals, so the
+ * built-ins used while a view is attached are captured when this file
+ * loads (as stack-parser.js does with Error.captureStackTrace).
+ */
+
+const Module = require('module');
+
+const defineProperty = Object.defineProperty;
+const hasOwnProperty = Object.prototype.hasOwnProperty;
+const apply = Reflect.apply;
+const builtinWrap = Module.wrap;
+const builtinCompile = Module.prototype._compile;
+
+const VIEW_KEY = '__dotnopeProcess';
+
+// The inner function keeps `process` out of the outer wrapper's signature
+// (which Node and tools inspect) and leaves the module's own 'use strict'
+// directive first in its body
+const WRAPPER_PREFIX =
+    '(function (exports, require, module, __filename, __dirname) { ' +
+    'return (function (exports, require, module, __filename, __dirname, process) { ';
+const WRAPPER_SUFFIX =
+    '\n}).call(this, exports, require, module, __filename, __dirname, ' +
+    `(function (m) { var v = m.${VIEW_KEY}; delete m.${VIEW_KEY}; return v || process; })(module)); });`;
+
+let installed = false;
+let viewForFile = null;
+
+/**
+ * Wrap module source with the process-injecting wrapper
+ * @param {string} script
+ * @returns {string}
+ */
+function wrap(script) {
+    // A hashbang is only valid at the very start of a script; comment it
+    // out in place so line numbers are unchanged
+    if (script.startsWith('#!')) {
+        script = '//' + script;
+    }
+    return WRAPPER_PREFIX + script + WRAPPER_SUFFIX;
+}
+
+/**
+ * Start injecting per-module process views
+ * @param {Function} getView - (filename) => process view, or null for the real process
+ */
+function install(getView) {
+    if (installed) {
+        return;
+    }
+
+    viewForFile = getView;
+
+    Module.wrap = wrap;
+    Module.prototype._compile = function (content, filename) {
+        // An outer hook (a later install by another copy of dotnope) wins.
+        // If Module.wrap was replaced since, that wrapper would run while
+        // the view is attached and could read it off the module: hand over
+        // nothing, and the module falls back to the global process.
+        const view = Module.wrap !== wrap || apply(hasOwnProperty, this, [VIEW_KEY])
+            ? null
+            : viewForFile(filename);
+        if (view) {
+            defineProperty(this, VIEW_KEY, { value: view, configurable: true });
+        }
+        try {
+            return apply(builtinCompile, this, [content, filename]);
+        } finally {
+            if (view) {
+                delete this[VIEW_KEY];
+            }
+        }
+    };
+
+    installed = true;
+}
+
+/**
+ * Stop injecting views into modules compiled from now on.
+ * Modules already loaded keep the view they were given.
+ */
+function uninstall() {
+    if (!installed) {
+        return;
+    }
+
+    Module.wrap = builtinWrap;
+    Module.prototype._compile = builtinCompile;
+    viewForFile = null;
+    installed = false;
+}
+
+/**
+ * Check if per-module injection is active
+ * @returns {boolean}
+ */
+function isInstalled() {
+    return installed;
+}
+
+module.exports = {
+    install,
+    uninstall,
+    isInstalled
+};
@@ -16,6 +16,7 @@ let nativeAvailable = false;
 let initializationError = null;
 let integrityVerified = false;
 let integrityError = null;
+let originalDlopen = null;
 
 /**
  * Verify the integrity of the native addon against the manifest
@@ -289,6 +290,108 @@ function getIsolateCount() {
     return native.getIsolateCount();
 }
 
+/**
+ * Redirect a native addon's getenv/setenv/open imports to policy-checked hooks
+ * by patching its GOT. Loads the object first if needed (without running its
+ * module initializer), so its Node registration code runs patched. The
+ * object's static constructors run during that load, before patching, and
+ * only the addon's own GOT is rewritten: libraries it links (libssl, ...)
+ * still call libc directly.
+ *
+ * @param {string} filename - Path to the .node file
+ * @param {Object} policy - { allowed, canWrite, canDelete, protectProc }
+ * @param {number} [flags] - dlopen flags used if the object is not loaded yet
+ * @returns {Object} { ok, slots, error }
+ */
+function patchNativeModule(filename, policy, flags) {
+    if (!isNativeAvailable()) {
+        return { ok: false, slots: 0, error: 'native addon not available' };
+    }
+    return native.patchNativeModule(filename, policy, flags);
+}
+
+/**
+ * Restore every GOT entry changed by patchNativeModule()
+ *
+ * @returns {boolean} Success
+ */
+function unpatchNativeModules() {
+    if (!isNativeAvailable()) {
+        return false;
+    }
+    return native.unpatchNativeModules();
+}
+
+/**
+ * Get per-addon counters for patched native modules
+ *
+ * @returns {Array|null} [{ path, slots, allowed, denied }] or null
+ */
+function getNativePatchStats() {
+    if (!isNativeAvailable()) {
+        return null;
+    }
+    return native.getNativePatchStats();
+}
+
+/**
+ * Patch every native addon as it is loaded.
+ * Wraps process.dlopen so each .node file is patched before Node runs its
+ * initializer; addons already in require.cache are patched immediately.
+ *
+ * @param {Function} getPolicy - (filename) => policy object, or null to skip
+ * @returns {boolean} Whether the hook was installed
+ */
+function installDlopenHook(getPolicy) {
+    if (!isNativeAvailable() || originalDlopen !== null) {
+        return false;
+    }
+
+    const path = require('path');
+    const ownAddon = path.resolve(__dirname, '../build/Release/dotnope_native.node');
+
+    const patch = (filename, flags) => {
+        if (typeof filename !== 'string' || path.resolve(filename) === ownAddon) {
+            return;
+        }
+        const policy = getPolicy(filename);
+        if (!policy) {
+            return;
+        }
+        const result = native.patchNativeModule(filename, policy, flags);
+        if (!result.ok) {
+            console.warn(`[dotnope] Could not patch native module ${filename}: ${result.error}`);
+        }
+    };
+
+    originalDlopen = process.dlopen;
+    const dlopen = originalDlopen;
+    process.dlopen = function (module, filename, flags) {
+        patch(filename, flags);
+        return dlopen.apply(this, arguments);
+    };
+
+    for (const filename of Object.keys(require.cache)) {
+        if (filename.endsWith('.node')) {
+            patch(filename);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Remove the process.dlopen wrapper and restore patched addons
+ */
+function uninstallDlopenHook() {
+    if (originalDlopen === null) {
+        return;
+    }
+    process.dlopen = originalDlopen;
+    originalDlopen = null;
+    unpatchNativeModules();
+}
+
 /**
  * Cleanup native resources
  */
@@ -340,6 +443,11 @@ module.exports = {
     getPromiseStats,
     isWorkerThread,
     getIsolateCount,
+    patchNativeModule,
+    unpatchNativeModules,
+    getNativePatchStats,
+    installDlopenHook,
+    uninstallDlopenHook,
     cleanup,
     isIntegrityVerified,
     getIntegrityError,
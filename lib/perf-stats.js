@@ -0,0 +1,293 @@
+/**
+ * perf-stats.js - Opt-in latency histograms and slow-check log for access checks
+ *
+ * A check is split into phases: attribution (finding the calling package),
+ * policy (the cached verdict) and report (denial bookkeeping and error
+ * construction). Each phase, the whole check, and the whole check per
+ * package are recorded in nanoseconds into perf_hooks histograms. Checks
+ * slower than a threshold are kept, with their phase breakdown and stack, in
+ * a fixed-size ring.
+ *
+ * Only the outermost check is timed; when disabled, begin() returns false
+ * and the other entry points return immediately.
+ */
+
+'use strict';
+
+const { createHistogram } = require('perf_hooks');
+const { getFormattedStack } = require('./stack-parser');
+
+const PHASE_ATTRIBUTION = 0;
+const PHASE_POLICY = 1;
+const PHASE_REPORT = 2;
+const PHASE_NAMES = ['attribution', 'policy', 'report'];
+
+const DEFAULT_SLOW_CHECK_THRESHOLD_MS = 1;
+const DEFAULT_SLOW_CHECK_LOG_SIZE = 64;
+
+// Bounded like the counters in access-stats.js; further packages are
+// only recorded in the phase histograms
+const MAX_PACKAGES = 4096;
+
+let enabled = false;
+let thresholdNs = 0;
+let slowLog = [];
+let slowLogSize = 0;
+let slowLogNext = 0;
+
+let phaseHistograms = [];
+let totalHistogram = null;
+const packageHistograms = new Map();
+
+// State of the check being timed
+let depth = 0;
+let checkStart = 0n;
+let lastMark = 0n;
+const phaseNs = new Float64Array(PHASE_NAMES.length);
+let currentPackage = null;
+let currentCallerInfo = null;
+
+/**
+ * Start recording
+ * @param {Object} [options]
+ * @param {number} [options.slowCheckThresholdMs] - Log checks slower than this (default 1)
+ * @param {number} [options.slowCheckLogSize] - Slow checks kept, oldest dropped first (default 64)
+ */
+function enable(options = {}) {
+    const thresholdMs = typeof options.slowCheckThresholdMs === 'number' && options.slowCheckThresholdMs >= 0
+        ? options.slowCheckThresholdMs
+        : DEFAULT_SLOW_CHECK_THRESHOLD_MS;
+    const logSize = Number.isInteger(options.slowCheckLogSize) && options.slowCheckLogSize >= 0
+        ? options.slowCheckLogSize
+        : DEFAULT_SLOW_CHECK_LOG_SIZE;
+
+    reset();
+    thresholdNs = thresholdMs * 1e6;
+    slowLogSize = logSize;
+    enabled = true;
+}
+
+/**
+ * Stop recording and drop all samples
+ */
+function disable() {
+    enabled = false;
+    reset();
+}
+
+/**
+ * Drop all samples, keeping the current settings
+ */
+function reset() {
+    phaseHistograms = PHASE_NAMES.map(() => createHistogram());
+    totalHistogram = createHistogram();
+    packageHistograms.clear();
+    slowLog = [];
+    slowLogNext = 0;
+    depth = 0;
+}
+
+/**
+ * Check if recording is on
+ * @returns {boolean}
+ */
+function isEnabled() {
+    return enabled;
+}
+
+/**
+ * Start timing a check. Every call must be paired with end().
+ * @returns {boolean} Whether the check is timed (recording on)
+ */
+function begin() {
+    if (!enabled) {
+        return false;
+    }
+    if (depth++ === 0) {
+        checkStart = process.hrtime.bigint();
+        lastMark = checkStart;
+        phaseNs.fill(0);
+        currentPackage = null;
+        currentCallerInfo = null;
+    }
+    return true;
+}
+
+/**
+ * Close the current phase of the outermost check
+ * @param {number} phase - PHASE_ATTRIBUTION, PHASE_POLICY or PHASE_REPORT
+ */
+function mark(phase) {
+    if (depth !== 1) {
+        return;
+    }
+    const now = process.hrtime.bigint();
+    phaseNs[phase] += Number(now - lastMark);
+    lastMark = now;
+}
+
+/**
+ * Close the attribution phase and note who the check is for
+ * @param {string|null} packageName
+ * @param {Object|null} callerInfo
+ */
+function attribute(packageName, callerInfo) {
+    if (depth !== 1) {
+        return;
+    }
+    mark(PHASE_ATTRIBUTION);
+    currentPackage = packageName;
+    currentCallerInfo = callerInfo;
+}
+
+/**
+ * Record a value in a histogram, which only accepts integers >= 1
+ * @param {Object} histogram
+ * @param {number} ns
+ */
+function recordNs(histogram, ns) {
+    histogram.record(ns >= 1 ? Math.round(ns) : 1);
+}
+
+/**
+ * Finish timing a check. Time since the last phase mark counts as report.
+ * @param {string} envVar
+ * @param {string} operation
+ * @param {string|undefined} trap
+ * @param {boolean} allowed - false when denied (silently or by throwing)
+ */
+function end(envVar, operation, trap, allowed) {
+    if (--depth !== 0) {
+        return;
+    }
+
+    const now = process.hrtime.bigint();
+    phaseNs[PHASE_REPORT] += Number(now - lastMark);
+    const totalNs = Number(now - checkStart);
+
+    for (let phase = 0; phase < PHASE_NAMES.length; phase++) {
+        if (phaseNs[phase] > 0) {
+            recordNs(phaseHistograms[phase], phaseNs[phase]);
+        }
+    }
+    recordNs(totalHistogram, totalNs);
+
+    if (currentPackage !== null) {
+        let histogram = packageHistograms.get(currentPackage);
+        if (!histogram && packageHistograms.size < MAX_PACKAGES) {
+            histogram = createHistogram();
+            packageHistograms.set(currentPackage, histogram);
+        }
+        if (histogram) {
+            recordNs(histogram, totalNs);
+        }
+    }
+
+    if (totalNs >= thresholdNs && slowLogSize > 0) {
+        logSlowCheck(envVar, operation, trap, allowed, totalNs);
+    }
+}
+
+/**
+ * Add an entry to the slow-check ring
+ * @param {string} envVar
+ * @param {string} operation
+ * @param {string|undefined} trap
+ * @param {boolean} allowed
+ * @param {number} totalNs
+ */
+function logSlowCheck(envVar, operation, trap, allowed, totalNs) {
+    const callerInfo = currentCallerInfo;
+    const phases = {};
+    for (let phase = 0; phase < PHASE_NAMES.length; phase++) {
+        phases[PHASE_NAMES[phase]] = phaseNs[phase] / 1e6;
+    }
+
+    const entry = {
+        timestamp: Date.now(),
+        durationMs: totalNs / 1e6,
+        phases,
+        packageName: currentPackage,
+        envVar,
+        operation,
+        trap: trap || null,
+        allowed,
+        fileName: callerInfo ? callerInfo.fileName : null,
+        lineNumber: callerInfo ? callerInfo.lineNumber : null,
+        functionName: callerInfo ? callerInfo.functionName : null,
+        isEval: callerInfo ? Boolean(callerInfo.isEval) : false,
+        stack: getFormattedStack(2)
+    };
+
+    if (slowLog.length < slowLogSize) {
+        slowLog.push(entry);
+    } else {
+        slowLog[slowLogNext] = entry;
+    }
+    slowLogNext = (slowLogNext + 1) % slowLogSize;
+}
+
+/**
+ * Summarize a histogram in nanoseconds
+ * @param {Object} histogram
+ * @returns {Object} { count, min, max, mean, stddev, p50, p90, p99, p999 }
+ */
+function summarize(histogram) {
+    if (histogram.count === 0) {
+        return { count: 0, min: 0, max: 0, mean: 0, stddev: 0, p50: 0, p90: 0, p99: 0, p999: 0 };
+    }
+    return {
+        count: histogram.count,
+        min: histogram.min,
+        max: histogram.max,
+        mean: histogram.mean,
+        stddev: histogram.stddev,
+        p50: histogram.percentile(50),
+        p90: histogram.percentile(90),
+        p99: histogram.percentile(99),
+        p999: histogram.percentile(99.9)
+    };
+}
+
+/**
+ * Get the recorded latencies
+ * @returns {Object|null} { phases: { attribution, policy, report }, total,
+ *   packages: { [name]: summary }, slowChecks: [...] } with summaries in
+ *   nanoseconds and slow checks oldest first, or null when not enabled
+ */
+function getSnapshot() {
+    if (!enabled) {
+        return null;
+    }
+
+    const phases = {};
+    for (let phase = 0; phase < PHASE_NAMES.length; phase++) {
+        phases[PHASE_NAMES[phase]] = summarize(phaseHistograms[phase]);
+    }
+
+    const packages = {};
+    for (const [packageName, histogram] of packageHistograms) {
+        packages[packageName] = summarize(histogram);
+    }
+
+    const slowChecks = slowLog.length < slowLogSize
+        ? slowLog.slice()
+        : slowLog.slice(slowLogNext).concat(slowLog.slice(0, slowLogNext));
+
+    return { phases, total: summarize(totalHistogram), packages, slowChecks };
+}
+
+module.exports = {
+    PHASE_ATTRIBUTION,
+    PHASE_POLICY,
+    PHASE_REPORT,
+    enable,
+    disable,
+    reset,
+    isEnabled,
+    begin,
+    mark,
+    attribute,
+    end,
+    getSnapshot
+};
@@ -0,0 +1,415 @@
+/**
+ * policy-compiler.js - Compile a normalized whitelist into constant-time lookup tables
+ *
+ * Package and variable names are interned to integer ids. For each operation
+ * (read, write, delete) a flat Uint32Array holds, per variable, a bitset of
+ * the packages allowed that operation on it, and a separate bitset row holds
+ * the packages granted '*'. Peer-dependency grants (allowPeerDependencies)
+ * are expanded into the read bitsets at compile time, so a check is two Map
+ * lookups and a bit test, and never touches the filesystem.
+ *
+ * Pattern entries (OTEL_*, see env-pattern.js) are kept apart, each with a
+ * bitset of the (operation, package) pairs it grants. They are matched by
+ * one lazily built automaton per policy, and the combined grants are
+ * memoized per variable name, so a variable no exact entry covers costs a
+ * single automaton walk however many patterns there are.
+ *
+ * Variables in the public tier (__options__.publicVars, autoPublicVars) are
+ * kept as exact names and patterns; isPublic() answers from a per-name memo.
+ * A pattern never makes a name that looks like a secret public.
+ *
+ * The result contains only Maps, arrays and typed arrays, so it survives
+ * structured cloning (e.g. workerData) unchanged; the automaton is rebuilt
+ * on first use.
+ */
+
+'use strict';
+
+const { getDependenciesWithLimit, warnDeepPeerGrant } = require('./dependency-resolver');
+const { isPattern, createMatcher } = require('./env-pattern');
+
+const POLICY_VERSION = 1;
+
+const OPERATIONS = ['read', 'write', 'delete'];
+const OPERATION_INDEX = { read: 0, write: 1, delete: 2 };
+
+// Per-package config field listing the variables each operation may touch
+const OPERATION_KEYS = ['allowed', 'canWrite', 'canDelete'];
+
+// Bound on variable names whose pattern grants are memoized per policy
+const MAX_MEMOIZED_VARS = 65536;
+
+// Policy -> { matcher, grantsByVar }, built on first pattern lookup
+const patternState = new WeakMap();
+
+// Policy -> { names, matcher, byVar }, built on first isPublic()
+const publicState = new WeakMap();
+
+// Variables read on hot paths by many libraries that carry no secrets,
+// made public by __options__.autoPublicVars
+const DEFAULT_PUBLIC_VARS = [
+    'NODE_ENV', 'NODE_DEBUG', 'NODE_NO_WARNINGS', 'NODE_PENDING_DEPRECATION',
+    'TZ', 'LANG', 'LANGUAGE', 'LC_*', 'TERM', 'COLORTERM', 'TERM_PROGRAM',
+    'DEBUG', 'DEBUG_*', 'LOG_LEVEL', 'LOGLEVEL', 'FORCE_COLOR', 'NO_COLOR', 'NODE_DISABLE_COLORS',
+    'CI', 'CONTINUOUS_INTEGRATION', 'BUILD_NUMBER', 'UV_THREADPOOL_SIZE',
+    'TMPDIR', 'TMP', 'TEMP', 'HOME', 'USER', 'SHELL', 'PATH'
+];
+
+// Names a pattern must not make public: anything that may hold a credential
+// or embed one (connection URLs)
+const SECRET_NAME = /SECRET|TOKEN|PASS|PWD|KEY|CRED|AUTH|PRIVATE|SESSION|COOKIE|SIGN|SALT|CERT|DSN|_URL$|_URI$/i;
+
+/**
+ * Intern a name
+ * @param {Map<string, number>} ids
+ * @param {string[]} names
+ * @param {string} name
+ * @returns {number}
+ */
+function intern(ids, names, name) {
+    let id = ids.get(name);
+    if (id === undefined) {
+        id = names.length;
+        ids.set(name, id);
+        names.push(name);
+    }
+    return id;
+}
+
+/**
+ * Packages that inherit a package's read grants (allowPeerDependencies)
+ * @param {string} packageName
+ * @param {Object} packageConfig - Normalized package entry
+ * @returns {Set<string>}
+ */
+function expandPeers(packageName, packageConfig) {
+    if (!packageConfig.allowPeerDependencies) {
+        return new Set();
+    }
+
+    const depthLimit = typeof packageConfig.peerDepthLimit === 'number' ? packageConfig.peerDepthLimit : 1;
+    const excludePackages = new Set(packageConfig.excludePeerDependencies || []);
+    const peers = getDependenciesWithLimit(packageName, depthLimit, excludePackages);
+
+    if (depthLimit > 1) {
+        for (const envVar of packageConfig.allowed) {
+            if (typeof envVar === 'string' && !envVar.startsWith('NODE_') && !envVar.startsWith('npm_')) {
+                warnDeepPeerGrant(packageName, envVar, peers.size, depthLimit);
+            }
+        }
+    }
+
+    return peers;
+}
+
+/**
+ * Check if a variable name looks like it holds a secret
+ * @param {string} envVar
+ * @returns {boolean}
+ */
+function looksSecret(envVar) {
+    return SECRET_NAME.test(envVar);
+}
+
+/**
+ * List the public tier entries (names and patterns) of __options__
+ * @param {Object} options - __options__ (publicVars, autoPublicVars)
+ * @returns {string[]}
+ */
+function listPublicVars(options) {
+    const entries = [...(options.publicVars || []), ...(options.autoPublicVars ? DEFAULT_PUBLIC_VARS : [])];
+    return [...new Set(entries.filter(envVar => typeof envVar === 'string' && envVar !== '*'))];
+}
+
+/**
+ * Split the public tier into exact names and patterns
+ * @param {Object} options - Normalized __options__
+ * @returns {Object} { publicNames, publicPatterns }
+ */
+function compilePublicTier(options) {
+    const publicNames = new Set();
+    const publicPatterns = new Set();
+
+    for (const envVar of listPublicVars(options)) {
+        if (isPattern(envVar)) {
+            publicPatterns.add(envVar);
+        } else {
+            if (looksSecret(envVar)) {
+                console.warn(`[dotnope] WARNING: publicVars lists "${envVar}", which looks like a secret; its reads will not be checked.`);
+            }
+            publicNames.add(envVar);
+        }
+    }
+
+    return { publicNames: [...publicNames], publicPatterns: [...publicPatterns] };
+}
+
+/**
+ * Compile a normalized whitelist (see config-loader normalizeConfig)
+ * @param {Object} config - packageName -> { allowed, canWrite, canDelete, ... }
+ * @param {Object} [options] - Normalized __options__ (publicVars, autoPublicVars)
+ * @returns {Object} Frozen policy for isAllowed()
+ */
+function compilePolicy(config, options = {}) {
+    const packageIds = new Map();
+    const packageNames = [];
+    const varIds = new Map();
+    const varNames = [];
+    const patternIds = new Map();
+    const patternNames = [];
+
+    // Grants as (packageId, varName) lists per operation; '*' is kept as a name
+    const grants = OPERATIONS.map(() => []);
+
+    for (const [packageName, packageConfig] of Object.entries(config)) {
+        const packageId = intern(packageIds, packageNames, packageName);
+
+        for (let op = 0; op < OPERATIONS.length; op++) {
+            for (const envVar of packageConfig[OPERATION_KEYS[op]] || []) {
+                if (typeof envVar !== 'string') {
+                    continue;
+                }
+                if (isPattern(envVar)) {
+                    intern(patternIds, patternNames, envVar);
+                } else if (envVar !== '*') {
+                    intern(varIds, varNames, envVar);
+                }
+                grants[op].push(packageId, envVar);
+            }
+        }
+
+        // Peers read whatever the package reads, '*' included
+        for (const peer of expandPeers(packageName, packageConfig)) {
+            const peerId = intern(packageIds, packageNames, peer);
+            for (const envVar of packageConfig.allowed) {
+                if (typeof envVar === 'string') {
+                    grants[0].push(peerId, envVar);
+                }
+            }
+        }
+    }
+
+    const words = Math.max(1, Math.ceil(packageNames.length / 32));
+    const columns = [];
+    const wildcards = [];
+    const patterns = patternNames.map(glob => ({ glob, grants: new Uint32Array(OPERATIONS.length * words) }));
+
+    for (let op = 0; op < OPERATIONS.length; op++) {
+        const column = new Uint32Array(varNames.length * words);
+        const wildcard = new Uint32Array(words);
+        const list = grants[op];
+
+        for (let i = 0; i < list.length; i += 2) {
+            const packageId = list[i];
+            const envVar = list[i + 1];
+            const bit = 1 << (packageId & 31);
+            if (envVar === '*') {
+                wildcard[packageId >>> 5] |= bit;
+            } else if (isPattern(envVar)) {
+                patterns[patternIds.get(envVar)].grants[op * words + (packageId >>> 5)] |= bit;
+            } else {
+                column[varIds.get(envVar) * words + (packageId >>> 5)] |= bit;
+            }
+        }
+
+        columns.push(column);
+        wildcards.push(wildcard);
+    }
+
+    const { publicNames, publicPatterns } = compilePublicTier(options);
+
+    return freezePolicy({
+        version: POLICY_VERSION,
+        packageIds,
+        packageNames,
+        varIds,
+        varNames,
+        words,
+        columns,
+        wildcards,
+        patterns,
+        publicNames,
+        publicPatterns
+    });
+}
+
+/**
+ * Freeze a policy's object structure (typed array contents cannot be frozen)
+ * @param {Object} policy
+ * @returns {Object} The same policy
+ */
+function freezePolicy(policy) {
+    Object.freeze(policy.packageNames);
+    Object.freeze(policy.varNames);
+    Object.freeze(policy.columns);
+    Object.freeze(policy.wildcards);
+    for (const pattern of policy.patterns) {
+        Object.freeze(pattern);
+    }
+    Object.freeze(policy.patterns);
+    Object.freeze(policy.publicNames);
+    Object.freeze(policy.publicPatterns);
+    return Object.freeze(policy);
+}
+
+/**
+ * Check whether a value is a compiled policy of this version, e.g. one
+ * received from another thread
+ * @param {*} policy
+ * @returns {boolean}
+ */
+function isCompiledPolicy(policy) {
+    return policy !== null && typeof policy === 'object' &&
+        policy.version === POLICY_VERSION &&
+        policy.packageIds instanceof Map &&
+        policy.varIds instanceof Map &&
+        Array.isArray(policy.columns) && policy.columns.length === OPERATIONS.length &&
+        Array.isArray(policy.wildcards) && policy.wildcards.length === OPERATIONS.length &&
+        policy.columns.every(column => column instanceof Uint32Array &&
+            column.length === policy.varIds.size * policy.words) &&
+        policy.wildcards.every(wildcard => wildcard instanceof Uint32Array &&
+            wildcard.length === policy.words) &&
+        Array.isArray(policy.patterns) &&
+        policy.patterns.every(pattern => pattern !== null && isPattern(pattern.glob) &&
+            pattern.grants instanceof Uint32Array &&
+            pattern.grants.length === OPERATIONS.length * policy.words) &&
+        Array.isArray(policy.publicNames) && policy.publicNames.every(name => typeof name === 'string') &&
+        Array.isArray(policy.publicPatterns) && policy.publicPatterns.every(isPattern) &&
+        policy.words >= Math.ceil(policy.packageIds.size / 32);
+}
+
+/**
+ * Combined grants of every pattern a variable matches
+ * @param {Object} policy
+ * @param {string} envVar
+ * @returns {Uint32Array|null} Bitset indexed like pattern grants, or null if none match
+ */
+function patternGrants(policy, envVar) {
+    let state = patternState.get(policy);
+    if (!state) {
+        state = { matcher: createMatcher(policy.patterns.map(pattern => pattern.glob)), grantsByVar: new Map() };
+        patternState.set(policy, state);
+    }
+
+    let grants = state.grantsByVar.get(envVar);
+    if (grants !== undefined) {
+        return grants;
+    }
+
+    const matches = state.matcher.match(envVar);
+    if (matches.length === 0) {
+        grants = null;
+    } else if (matches.length === 1) {
+        grants = policy.patterns[matches[0]].grants;
+    } else {
+        grants = new Uint32Array(OPERATIONS.length * policy.words);
+        for (const index of matches) {
+            const patternBits = policy.patterns[index].grants;
+            for (let i = 0; i < grants.length; i++) {
+                grants[i] |= patternBits[i];
+            }
+        }
+    }
+
+    if (state.grantsByVar.size < MAX_MEMOIZED_VARS) {
+        state.grantsByVar.set(envVar, grants);
+    }
+    return grants;
+}
+
+/**
+ * Check an access against a compiled policy
+ * @param {Object} policy - From compilePolicy()
+ * @param {string} packageName
+ * @param {string} envVar
+ * @param {string} operation - 'read', 'write' or 'delete'
+ * @returns {boolean}
+ */
+function isAllowed(policy, packageName, envVar, operation) {
+    const op = OPERATION_INDEX[operation];
+    const packageId = policy.packageIds.get(packageName);
+    if (op === undefined || packageId === undefined) {
+        return false;
+    }
+
+    const word = packageId >>> 5;
+    const bit = 1 << (packageId & 31);
+    if ((policy.wildcards[op][word] & bit) !== 0) {
+        return true;
+    }
+
+    const varId = policy.varIds.get(envVar);
+    if (varId !== undefined && (policy.columns[op][varId * policy.words + word] & bit) !== 0) {
+        return true;
+    }
+
+    if (policy.patterns.length === 0) {
+        return false;
+    }
+    const grants = patternGrants(policy, envVar);
+    return grants !== null && (grants[op * policy.words + word] & bit) !== 0;
+}
+
+/**
+ * Check if a variable is in the public tier, whose reads need no attribution
+ * @param {Object} policy
+ * @param {string} envVar
+ * @returns {boolean}
+ */
+function isPublic(policy, envVar) {
+    if (policy.publicNames.length === 0 && policy.publicPatterns.length === 0) {
+        return false;
+    }
+
+    let state = publicState.get(policy);
+    if (!state) {
+        state = {
+            names: new Set(policy.publicNames),
+            matcher: policy.publicPatterns.length > 0 ? createMatcher(policy.publicPatterns) : null,
+            byVar: new Map()
+        };
+        publicState.set(policy, state);
+    }
+
+    let result = state.byVar.get(envVar);
+    if (result !== undefined) {
+        return result;
+    }
+
+    result = state.names.has(envVar) ||
+        (state.matcher !== null && !looksSecret(envVar) && state.matcher.match(envVar).length > 0);
+
+    if (state.byVar.size < MAX_MEMOIZED_VARS) {
+        state.byVar.set(envVar, result);
+    }
+    return result;
+}
+
+/**
+ * Check whether a package may perform an operation on every variable
+ * @param {Object} policy
+ * @param {string} packageName
+ * @param {string} operation
+ * @returns {boolean}
+ */
+function hasWildcard(policy, packageName, operation) {
+    const op = OPERATION_INDEX[operation];
+    const packageId = policy.packageIds.get(packageName);
+    if (op === undefined || packageId === undefined) {
+        return false;
+    }
+    return (policy.wildcards[op][packageId >>> 5] & (1 << (packageId & 31))) !== 0;
+}
+
+module.exports = {
+    POLICY_VERSION,
+    compilePolicy,
+    freezePolicy,
+    isCompiledPolicy,
+    isAllowed,
+    isPublic,
+    listPublicVars,
+    looksSecret,
+    hasWildcard,
+    DEFAULT_PUBLIC_VARS
+};
@@ -1,14 +1,17 @@
 /**
  * preload-generator.js - Generate LD_PRELOAD policy from whitelist config
  *
- * Generates the DOTNOPE_POLICY environment variable value from the
- * environmentWhitelist configuration for use with libdotnope_preload.so
+ * Generates the DOTNOPE_POLICY environment variable value, or a compiled
+ * binary policy file for DOTNOPE_POLICY_FILE, from the environmentWhitelist
+ * configuration for use with libdotnope_preload.so
  */
 
 'use strict';
 
 const fs = require('fs');
 const path = require('path');
+const { isPattern, createMatcher } = require('./env-pattern');
+const { listPublicVars, looksSecret } = require('./policy-compiler');
 
 /**
  * Generate DOTNOPE_POLICY from whitelist configuration
@@ -52,17 +55,235 @@ function generatePolicy(config) {
     return [...allowedVars].sort().join(',');
 }
 
+// Compiled policy format - must match native/preload/dotnope_policy.h
+const POLICY_MAGIC = 'DNPOLICY';
+const POLICY_VERSION = 1;
+const POLICY_HEADER_SIZE = 64;
+const POLICY_VAR_SIZE = 16;
+const POLICY_PACKAGE_SIZE = 24;
+const POLICY_FLAG_ALLOW_ALL = 0x1;
+const PACKAGE_FLAG_WILDCARD = 0x1;
+
+// Policy segment format (DOTNOPE_POLICY_SHM) - see dotnope_policy.h
+const SEGMENT_MAGIC = 'DNPSEGMT';
+const SEGMENT_VERSION = 1;
+const SEGMENT_HEADER_SIZE = 64;
+const SEGMENT_GENERATION_OFFSET = 16;
+const DEFAULT_SEGMENT_SLOT_SIZE = 256 * 1024;
+
+// Counter region format (DOTNOPE_STATS) - see dotnope_stats.h
+const STATS_MAGIC = 'DNPSTATS';
+const STATS_VERSION = 1;
+const STATS_HEADER_SIZE = 128;
+const STATS_VAR_SIZE = 136;
+const STATS_SLOT_READY = 2;
+const STATS_OPERATIONS = ['getenv', 'setenv', 'unsetenv', 'open'];
+const DEFAULT_STATS_DIR = '/dev/shm';
+
+// Variables the preload library always allows (mirrors is_allowed_len)
+const ESSENTIAL_VARS = ['PATH', 'HOME', 'USER', 'TERM', 'LANG', 'SHELL', 'LC_ALL'];
+const ESSENTIAL_PREFIX = 'DOTNOPE_';
+
+// Variables Node and libc read at startup, kept by generateMinimalEnv
+const RUNTIME_VARS = [
+    'NODE_OPTIONS', 'NODE_PATH', 'NODE_ENV', 'NODE_EXTRA_CA_CERTS', 'NODE_ICU_DATA',
+    'NODE_NO_WARNINGS', 'NODE_PENDING_DEPRECATION', 'UV_THREADPOOL_SIZE',
+    'TZ', 'TMPDIR', 'SSL_CERT_FILE', 'SSL_CERT_DIR', 'LD_PRELOAD'
+];
+const RUNTIME_PREFIXES = ['LC_', ESSENTIAL_PREFIX];
+
 /**
- * Generate policy from a package.json file
+ * 32-bit FNV-1a hash, as used by the preload library
+ * @param {Buffer} buf
+ * @param {number} [start]
+ * @param {number} [end]
+ * @returns {number}
+ */
+function fnv1a(buf, start = 0, end = buf.length) {
+    let hash = 0x811c9dc5;
+    for (let i = start; i < end; i++) {
+        hash ^= buf[i];
+        hash = Math.imul(hash, 0x01000193);
+    }
+    return hash >>> 0;
+}
+
+/**
+ * Compile whitelist configuration into a binary policy image for
+ * DOTNOPE_POLICY_FILE: a checksummed hash table of allowed variables
+ * plus one section per package listing the variables it contributes.
+ * @param {Object} config - Whitelist configuration object
+ * @returns {Buffer} Compiled policy image
+ */
+function compilePolicy(config) {
+    const packages = [];
+    const varNames = new Set();
+    let allowAll = false;
+
+    for (const packageName of Object.keys(config).sort()) {
+        if (packageName === '__options__') {
+            continue;
+        }
+
+        const packageConfig = config[packageName];
+        const vars = new Set([...(packageConfig.allowed || []), ...(packageConfig.canWrite || [])]);
+        const wildcard = vars.delete('*');
+        allowAll = allowAll || wildcard;
+
+        for (const envVar of vars) {
+            varNames.add(envVar);
+        }
+        packages.push({ name: packageName, vars: [...vars].sort(), wildcard });
+    }
+
+    const vars = [...varNames].sort();
+    const varIndex = new Map(vars.map((name, i) => [name, i]));
+
+    // String table: variable names first, then package names
+    const stringChunks = [];
+    let stringsSize = 0;
+    const addString = (str) => {
+        const bytes = Buffer.from(str + '\0', 'utf8');
+        const offset = stringsSize;
+        stringChunks.push(bytes);
+        stringsSize += bytes.length;
+        return { offset, length: bytes.length - 1, bytes };
+    };
+
+    const varEntries = vars.map(name => {
+        const str = addString(name);
+        return { ...str, hash: fnv1a(str.bytes, 0, str.length) };
+    });
+    const packageEntries = packages.map(pkg => ({ ...addString(pkg.name), pkg }));
+    const memberCount = packages.reduce((sum, pkg) => sum + pkg.vars.length, 0);
+
+    // Keep the table at most half full so probe sequences stay short
+    let bucketCount = 8;
+    while (bucketCount < vars.length * 2) {
+        bucketCount *= 2;
+    }
+
+    const varsOffset = POLICY_HEADER_SIZE;
+    const bucketsOffset = varsOffset + vars.length * POLICY_VAR_SIZE;
+    const packagesOffset = bucketsOffset + bucketCount * 4;
+    const membersOffset = packagesOffset + packages.length * POLICY_PACKAGE_SIZE;
+    const stringsOffset = membersOffset + memberCount * 4;
+    const totalSize = stringsOffset + stringsSize;
+
+    const buf = Buffer.alloc(totalSize);
+
+    varEntries.forEach((entry, i) => {
+        const at = varsOffset + i * POLICY_VAR_SIZE;
+        buf.writeUInt32LE(entry.hash, at);
+        buf.writeUInt32LE(entry.offset, at + 4);
+        buf.writeUInt32LE(entry.length, at + 8);
+
+        let bucket = entry.hash & (bucketCount - 1);
+        while (buf.readUInt32LE(bucketsOffset + bucket * 4) !== 0) {
+            bucket = (bucket + 1) & (bucketCount - 1);
+        }
+        buf.writeUInt32LE(i + 1, bucketsOffset + bucket * 4);
+    });
+
+    let member = 0;
+    packageEntries.forEach((entry, i) => {
+        const at = packagesOffset + i * POLICY_PACKAGE_SIZE;
+        buf.writeUInt32LE(entry.offset, at);
+        buf.writeUInt32LE(entry.length, at + 4);
+        buf.writeUInt32LE(member, at + 8);
+        buf.writeUInt32LE(entry.pkg.vars.length, at + 12);
+        buf.writeUInt32LE(entry.pkg.wildcard ? PACKAGE_FLAG_WILDCARD : 0, at + 16);
+        for (const envVar of entry.pkg.vars) {
+            buf.writeUInt32LE(varIndex.get(envVar), membersOffset + member * 4);
+            member++;
+        }
+    });
+
+    Buffer.concat(stringChunks, stringsSize).copy(buf, stringsOffset);
+
+    buf.write(POLICY_MAGIC, 0, 'latin1');
+    buf.writeUInt32LE(POLICY_VERSION, 8);
+    buf.writeUInt32LE(allowAll ? POLICY_FLAG_ALLOW_ALL : 0, 12);
+    buf.writeUInt32LE(totalSize, 16);
+    buf.writeUInt32LE(vars.length, 24);
+    buf.writeUInt32LE(bucketCount, 28);
+    buf.writeUInt32LE(packages.length, 32);
+    buf.writeUInt32LE(varsOffset, 36);
+    buf.writeUInt32LE(bucketsOffset, 40);
+    buf.writeUInt32LE(packagesOffset, 44);
+    buf.writeUInt32LE(membersOffset, 48);
+    buf.writeUInt32LE(memberCount, 52);
+    buf.writeUInt32LE(stringsOffset, 56);
+    buf.writeUInt32LE(stringsSize, 60);
+    buf.writeUInt32LE(fnv1a(buf, POLICY_HEADER_SIZE), 20);
+
+    return buf;
+}
+
+/**
+ * Decode a compiled policy image (for inspection and tests)
+ * @param {Buffer} buf - Compiled policy image
+ * @returns {Object} { allowAll, vars, packages }
+ */
+function readCompiledPolicy(buf) {
+    if (buf.length < POLICY_HEADER_SIZE || buf.toString('latin1', 0, 8) !== POLICY_MAGIC) {
+        throw new Error('dotnope: Not a compiled policy file');
+    }
+    if (buf.readUInt32LE(8) !== POLICY_VERSION) {
+        throw new Error(`dotnope: Unsupported policy version ${buf.readUInt32LE(8)}`);
+    }
+    if (buf.readUInt32LE(16) !== buf.length || fnv1a(buf, POLICY_HEADER_SIZE) !== buf.readUInt32LE(20)) {
+        throw new Error('dotnope: Compiled policy is corrupt (size or checksum mismatch)');
+    }
+
+    const varCount = buf.readUInt32LE(24);
+    const packageCount = buf.readUInt32LE(32);
+    const varsOffset = buf.readUInt32LE(36);
+    const packagesOffset = buf.readUInt32LE(44);
+    const membersOffset = buf.readUInt32LE(48);
+    const stringsOffset = buf.readUInt32LE(56);
+    const readString = (offset, length) =>
+        buf.toString('utf8', stringsOffset + offset, stringsOffset + offset + length);
+
+    const vars = [];
+    for (let i = 0; i < varCount; i++) {
+        const at = varsOffset + i * POLICY_VAR_SIZE;
+        vars.push(readString(buf.readUInt32LE(at + 4), buf.readUInt32LE(at + 8)));
+    }
+
+    const packages = {};
+    for (let i = 0; i < packageCount; i++) {
+        const at = packagesOffset + i * POLICY_PACKAGE_SIZE;
+        const first = buf.readUInt32LE(at + 8);
+        const count = buf.readUInt32LE(at + 12);
+        const members = [];
+        for (let m = first; m < first + count; m++) {
+            members.push(vars[buf.readUInt32LE(membersOffset + m * 4)]);
+        }
+        packages[readString(buf.readUInt32LE(at), buf.readUInt32LE(at + 4))] = {
+            vars: members,
+            wildcard: (buf.readUInt32LE(at + 16) & PACKAGE_FLAG_WILDCARD) !== 0
+        };
+    }
+
+    return {
+        allowAll: (buf.readUInt32LE(12) & POLICY_FLAG_ALLOW_ALL) !== 0,
+        vars,
+        packages
+    };
+}
+
+/**
+ * Read and normalize the environmentWhitelist from a package.json file
+ * (simplified version of config-loader)
  * @param {string} pkgPath - Path to package.json
- * @returns {string} Policy string
+ * @returns {Object} Whitelist configuration
  */
-function generatePolicyFromPackageJson(pkgPath) {
+function loadWhitelistConfig(pkgPath) {
     const pkgContent = fs.readFileSync(pkgPath, 'utf8');
     const pkg = JSON.parse(pkgContent);
     const whitelist = pkg.environmentWhitelist || {};
 
-    // Normalize config (simplified version of config-loader)
     const config = {};
     for (const [packageName, rawConfig] of Object.entries(whitelist)) {
         if (packageName === '__options__') continue;
@@ -77,7 +298,452 @@ function generatePolicyFromPackageJson(pkgPath) {
         }
     }
 
-    return generatePolicy(config);
+    return config;
+}
+
+/**
+ * Read the public tier (__options__.publicVars, autoPublicVars) from a
+ * package.json file
+ * @param {string} pkgPath - Path to package.json
+ * @returns {string[]} Public names and patterns
+ */
+function loadPublicVars(pkgPath) {
+    const pkg = JSON.parse(fs.readFileSync(pkgPath, 'utf8'));
+    const options = (pkg.environmentWhitelist || {}).__options__;
+    return listPublicVars(options && typeof options === 'object' ? options : {});
+}
+
+/**
+ * Generate policy from a package.json file
+ * @param {string} pkgPath - Path to package.json
+ * @returns {string} Policy string
+ */
+function generatePolicyFromPackageJson(pkgPath) {
+    return generatePolicy(loadWhitelistConfig(pkgPath));
+}
+
+/**
+ * Compile the policy from a package.json file and write it to disk.
+ * The file is written to a temporary name and renamed into place so that
+ * processes mapping the previous version keep a consistent image.
+ * @param {string} pkgPath - Path to package.json
+ * @param {string} outPath - Destination for the compiled policy
+ * @returns {string} Absolute path of the written policy file
+ */
+function compilePolicyFile(pkgPath, outPath) {
+    const image = compilePolicy(loadWhitelistConfig(pkgPath));
+    const target = path.resolve(outPath);
+    const tmpPath = `${target}.${process.pid}.tmp`;
+
+    fs.writeFileSync(tmpPath, image, { mode: 0o644 });
+    fs.renameSync(tmpPath, target);
+
+    return target;
+}
+
+/**
+ * murmur3 finalizer, used for the second level of the baked perfect hash
+ * @param {number} hash
+ * @returns {number}
+ */
+function fmix32(hash) {
+    hash ^= hash >>> 16;
+    hash = Math.imul(hash, 0x85ebca6b);
+    hash ^= hash >>> 13;
+    hash = Math.imul(hash, 0xc2b2ae35);
+    hash ^= hash >>> 16;
+    return hash >>> 0;
+}
+
+/**
+ * Build a hash-and-displace (CHD) perfect hash: names are grouped into
+ * buckets by FNV-1a, and each bucket gets a displacement that sends all
+ * of its names to free table slots via fmix32(hash ^ d * golden)
+ * @param {string[]} names - Distinct variable names
+ * @returns {Object} { tableSize, displacements, slots } where slots[i] is a name or null
+ */
+function buildPerfectHash(names) {
+    const hashes = names.map(name => fnv1a(Buffer.from(name, 'utf8')));
+    if (new Set(hashes).size !== hashes.length) {
+        throw new Error('dotnope: FNV-1a collision between whitelisted names; cannot bake policy');
+    }
+
+    const nextPow2 = (n) => {
+        let size = 1;
+        while (size < n) size *= 2;
+        return size;
+    };
+    const bucketCount = nextPow2(Math.max(1, Math.ceil(names.length / 4)));
+
+    for (let tableSize = nextPow2(Math.ceil(names.length * 1.25)); ; tableSize *= 2) {
+        const mask = tableSize - 1;
+        const buckets = Array.from({ length: bucketCount }, () => []);
+        names.forEach((name, i) => buckets[hashes[i] & (bucketCount - 1)].push(i));
+
+        const order = buckets
+            .map((members, index) => ({ members, index }))
+            .sort((a, b) => b.members.length - a.members.length);
+
+        const slots = new Array(tableSize).fill(null);
+        const displacements = new Array(bucketCount).fill(0);
+        let placed = true;
+
+        for (const { members, index } of order) {
+            if (members.length === 0) break;
+
+            let found = false;
+            for (let d = 0; d < (1 << 20) && !found; d++) {
+                const targets = members.map(i => fmix32(hashes[i] ^ Math.imul(d, 0x9e3779b9)) & mask);
+                if (new Set(targets).size === targets.length && targets.every(t => slots[t] === null)) {
+                    targets.forEach((t, k) => { slots[t] = names[members[k]]; });
+                    displacements[index] = d;
+                    found = true;
+                }
+            }
+            if (!found) {
+                placed = false;
+                break;
+            }
+        }
+
+        if (placed) {
+            return { tableSize, displacements, slots };
+        }
+    }
+}
+
+/**
+ * Quote a string as a C literal (non-printable and non-ASCII bytes as octal)
+ * @param {string} str
+ * @returns {string}
+ */
+function cString(str) {
+    let out = '"';
+    for (const byte of Buffer.from(str, 'utf8')) {
+        if (byte >= 0x20 && byte < 0x7f && byte !== 0x22 && byte !== 0x5c && byte !== 0x3f) {
+            out += String.fromCharCode(byte);
+        } else {
+            out += '\\' + byte.toString(8).padStart(3, '0');
+        }
+    }
+    return out + '"';
+}
+
+/**
+ * Generate dotnope_baked_policy.h: the whitelist compiled into a perfect
+ * hash table and a switch-based essential-variable check, for building a
+ * policy-specialized preload library with -DDOTNOPE_BAKED_POLICY
+ * @param {Object} config - Whitelist configuration object
+ * @param {Object} [options]
+ * @param {string} [options.source] - Description of the config source for the header comment
+ * @returns {string} C header text
+ */
+function generateBakedPolicyHeader(config, options = {}) {
+    const varNames = new Set();
+    let allowAll = false;
+
+    for (const [packageName, packageConfig] of Object.entries(config)) {
+        if (packageName === '__options__') continue;
+        for (const envVar of [...(packageConfig.allowed || []), ...(packageConfig.canWrite || [])]) {
+            if (envVar === '*') {
+                allowAll = true;
+            } else {
+                varNames.add(envVar);
+            }
+        }
+    }
+
+    const names = [...varNames].sort();
+    const { tableSize, displacements, slots } = buildPerfectHash(names);
+
+    const byLength = new Map();
+    for (const name of ESSENTIAL_VARS) {
+        if (!byLength.has(name.length)) byLength.set(name.length, []);
+        byLength.get(name.length).push(name);
+    }
+    const essentialCases = [...byLength.entries()]
+        .sort((a, b) => a[0] - b[0])
+        .map(([len, group]) => [
+            `    case ${len}:`,
+            `        return ${group.map(name => `memcmp(name, ${cString(name)}, ${len}) == 0`).join(' ||\n               ')};`
+        ].join('\n'));
+
+    const rows = (values, perLine) => {
+        const lines = [];
+        for (let i = 0; i < values.length; i += perLine) {
+            lines.push('    ' + values.slice(i, i + perLine).join(', ') + ',');
+        }
+        return lines.join('\n');
+    };
+
+    return `/**
+ * dotnope_baked_policy.h - Generated by lib/preload-generator.js
+ * (generateBakedPolicyHeader)${options.source ? ` from ${options.source}` : ''}. Do not edit.
+ *
+ * ${names.length} allowed variable(s)${allowAll ? ', wildcard (all variables allowed)' : ''}.
+ * Lookup: h = FNV-1a(name); d = displacements[h & (DNP_BAKED_BUCKETS - 1)];
+ * slot = fmix32(h ^ d * 0x9e3779b9) & (DNP_BAKED_TABLE_SIZE - 1).
+ */
+
+#ifndef DOTNOPE_BAKED_POLICY_H
+#define DOTNOPE_BAKED_POLICY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DNP_BAKED_ALLOW_ALL ${allowAll ? 1 : 0}
+#define DNP_BAKED_VAR_COUNT ${names.length}
+#define DNP_BAKED_BUCKETS ${displacements.length}
+#define DNP_BAKED_TABLE_SIZE ${tableSize}
+
+static const uint32_t dnp_baked_displacements[DNP_BAKED_BUCKETS] = {
+${rows(displacements.map(String), 12)}
+};
+
+static const char* const dnp_baked_names[DNP_BAKED_TABLE_SIZE] = {
+${rows(slots.map(name => name === null ? 'NULL' : cString(name)), 1)}
+};
+
+static const uint32_t dnp_baked_lengths[DNP_BAKED_TABLE_SIZE] = {
+${rows(slots.map(name => String(name === null ? 0 : Buffer.byteLength(name))), 16)}
+};
+
+static inline int dnp_baked_essential(const char* name, size_t len) {
+    if (len >= ${ESSENTIAL_PREFIX.length} && memcmp(name, ${cString(ESSENTIAL_PREFIX)}, ${ESSENTIAL_PREFIX.length}) == 0) return 1;
+
+    switch (len) {
+${essentialCases.join('\n')}
+    default:
+        return 0;
+    }
+}
+
+static inline int dnp_baked_contains(const char* name, size_t len) {
+    if (DNP_BAKED_ALLOW_ALL) return 1;
+
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+
+    uint32_t slot = hash ^ (dnp_baked_displacements[hash & (DNP_BAKED_BUCKETS - 1)] * 0x9e3779b9u);
+    slot ^= slot >> 16;
+    slot *= 0x85ebca6bu;
+    slot ^= slot >> 13;
+    slot *= 0xc2b2ae35u;
+    slot ^= slot >> 16;
+    slot &= DNP_BAKED_TABLE_SIZE - 1;
+
+    const char* candidate = dnp_baked_names[slot];
+    return candidate && dnp_baked_lengths[slot] == len && memcmp(candidate, name, len) == 0;
+}
+
+#endif /* DOTNOPE_BAKED_POLICY_H */
+`;
+}
+
+/**
+ * Write dotnope_baked_policy.h for the environmentWhitelist in package.json
+ * @param {string} pkgPath - Path to package.json
+ * @param {string} outPath - Header path to write
+ * @returns {string} Absolute path of the written header
+ */
+function writeBakedPolicyHeader(pkgPath, outPath) {
+    const header = generateBakedPolicyHeader(loadWhitelistConfig(pkgPath), {
+        source: path.basename(path.dirname(path.resolve(pkgPath))) + '/package.json'
+    });
+    const target = path.resolve(outPath);
+
+    fs.mkdirSync(path.dirname(target), { recursive: true });
+    fs.writeFileSync(target, header);
+    return target;
+}
+
+/**
+ * Read the header of an existing policy segment
+ * @param {number} fd - Open file descriptor of the segment
+ * @returns {Object|null} { slotSize, generation } or null if not a segment
+ */
+function readSegmentHeader(fd) {
+    const header = Buffer.alloc(SEGMENT_HEADER_SIZE);
+    if (fs.readSync(fd, header, 0, SEGMENT_HEADER_SIZE, 0) !== SEGMENT_HEADER_SIZE ||
+        header.toString('latin1', 0, 8) !== SEGMENT_MAGIC ||
+        header.readUInt32LE(8) !== SEGMENT_VERSION) {
+        return null;
+    }
+    return {
+        slotSize: header.readUInt32LE(12),
+        generation: header.readUInt32LE(SEGMENT_GENERATION_OFFSET)
+    };
+}
+
+/**
+ * Publish a new compiled policy into an existing policy segment.
+ * The image is written into the inactive slot first and the generation is
+ * bumped last, so preloaded processes pick it up on their next lookup
+ * without restarting. Only one controller may publish at a time.
+ * @param {string} segPath - Path of the policy segment
+ * @param {Object} config - Whitelist configuration object
+ * @returns {number} The new generation
+ */
+function publishPolicySegment(segPath, config) {
+    const image = compilePolicy(config);
+    const fd = fs.openSync(segPath, 'r+');
+
+    try {
+        const header = readSegmentHeader(fd);
+        if (!header) {
+            throw new Error(`dotnope: ${segPath} is not a policy segment`);
+        }
+        if (image.length > header.slotSize) {
+            throw new Error(
+                `dotnope: Compiled policy (${image.length} bytes) exceeds segment slot size ` +
+                `(${header.slotSize} bytes). Recreate the segment with a larger slotSize.`
+            );
+        }
+
+        const generation = (header.generation + 1) >>> 0;
+        const slotOffset = SEGMENT_HEADER_SIZE + (generation & 1) * header.slotSize;
+        fs.writeSync(fd, image, 0, image.length, slotOffset);
+
+        const genBuf = Buffer.alloc(4);
+        genBuf.writeUInt32LE(generation, 0);
+        fs.writeSync(fd, genBuf, 0, 4, SEGMENT_GENERATION_OFFSET);
+
+        return generation;
+    } finally {
+        fs.closeSync(fd);
+    }
+}
+
+/**
+ * Create a policy segment holding the compiled policy, or publish into it
+ * if a compatible segment already exists (an existing segment is never
+ * truncated, since running processes have it mapped).
+ * @param {string} segPath - Path of the policy segment (e.g. under /dev/shm)
+ * @param {Object} config - Whitelist configuration object
+ * @param {Object} [options]
+ * @param {number} [options.slotSize] - Bytes reserved for each policy image
+ * @returns {string} Absolute path of the segment
+ */
+function createPolicySegment(segPath, config, options = {}) {
+    const target = path.resolve(segPath);
+
+    if (fs.existsSync(target)) {
+        const fd = fs.openSync(target, 'r');
+        const header = readSegmentHeader(fd);
+        fs.closeSync(fd);
+        if (header) {
+            publishPolicySegment(target, config);
+            return target;
+        }
+    }
+
+    const image = compilePolicy(config);
+    let slotSize = options.slotSize || DEFAULT_SEGMENT_SLOT_SIZE;
+    slotSize = Math.max(slotSize, image.length);
+    slotSize = Math.ceil(slotSize / 8) * 8;
+
+    const segment = Buffer.alloc(SEGMENT_HEADER_SIZE + 2 * slotSize);
+    segment.write(SEGMENT_MAGIC, 0, 'latin1');
+    segment.writeUInt32LE(SEGMENT_VERSION, 8);
+    segment.writeUInt32LE(slotSize, 12);
+    segment.writeUInt32LE(0, SEGMENT_GENERATION_OFFSET);
+    image.copy(segment, SEGMENT_HEADER_SIZE);
+
+    const tmpPath = `${target}.${process.pid}.tmp`;
+    fs.writeFileSync(tmpPath, segment, { mode: 0o644 });
+    fs.renameSync(tmpPath, target);
+
+    return target;
+}
+
+/**
+ * Decode a preload counter region
+ * @param {Buffer} buf - Contents of a dotnope-stats-<pid> file
+ * @returns {Object} { pid, dropped, totals, vars } where totals and each
+ *                   vars[name] map operation -> { allowed, denied }
+ */
+function parsePreloadStats(buf) {
+    if (buf.length < STATS_HEADER_SIZE || buf.toString('latin1', 0, 8) !== STATS_MAGIC) {
+        throw new Error('dotnope: Not a preload stats region');
+    }
+    if (buf.readUInt32LE(8) !== STATS_VERSION) {
+        throw new Error(`dotnope: Unsupported stats version ${buf.readUInt32LE(8)}`);
+    }
+
+    const varSlots = buf.readUInt32LE(16);
+    const nameMax = buf.readUInt32LE(20);
+    const readCounts = (at) => {
+        const counts = {};
+        STATS_OPERATIONS.forEach((op, i) => {
+            counts[op] = {
+                denied: Number(buf.readBigUInt64LE(at + i * 16)),
+                allowed: Number(buf.readBigUInt64LE(at + i * 16 + 8))
+            };
+        });
+        return counts;
+    };
+
+    const vars = {};
+    for (let i = 0; i < varSlots; i++) {
+        const at = STATS_HEADER_SIZE + i * STATS_VAR_SIZE;
+        if (at + STATS_VAR_SIZE > buf.length) break;
+        if (buf.readUInt32LE(at) !== STATS_SLOT_READY) continue;
+
+        const nameEnd = buf.indexOf(0, at + 8);
+        const name = buf.toString('utf8', at + 8, nameEnd === -1 || nameEnd > at + 8 + nameMax ? at + 8 + nameMax : nameEnd);
+        const counts = readCounts(at + 8 + nameMax);
+
+        // Concurrent first use can place one name in two slots - merge them
+        if (vars[name]) {
+            for (const op of STATS_OPERATIONS) {
+                vars[name][op].allowed += counts[op].allowed;
+                vars[name][op].denied += counts[op].denied;
+            }
+        } else {
+            vars[name] = counts;
+        }
+    }
+
+    return {
+        pid: buf.readUInt32LE(12),
+        dropped: Number(buf.readBigUInt64LE(24)),
+        totals: readCounts(32),
+        vars
+    };
+}
+
+/**
+ * Read the live counters of a process running with DOTNOPE_STATS
+ * @param {number} pid - Process id
+ * @param {string} [dir] - Directory holding the stats regions
+ * @returns {Object} Parsed counters (see parsePreloadStats)
+ */
+function readPreloadStats(pid, dir = DEFAULT_STATS_DIR) {
+    const statsPath = path.join(dir, `dotnope-stats-${pid}`);
+    if (!fs.existsSync(statsPath)) {
+        throw new Error(`dotnope: No stats region for pid ${pid} in ${dir} (was it started with DOTNOPE_STATS?)`);
+    }
+    return parsePreloadStats(fs.readFileSync(statsPath));
+}
+
+/**
+ * List process ids that currently publish preload counters
+ * @param {string} [dir] - Directory holding the stats regions
+ * @returns {number[]}
+ */
+function listPreloadStats(dir = DEFAULT_STATS_DIR) {
+    try {
+        return fs.readdirSync(dir)
+            .map(name => /^dotnope-stats-(\d+)$/.exec(name))
+            .filter(Boolean)
+            .map(match => Number(match[1]))
+            .sort((a, b) => a - b);
+    } catch (err) {
+        return [];
+    }
 }
 
 /**
@@ -101,6 +767,25 @@ function findPreloadLibrary() {
     return null;
 }
 
+/**
+ * Find the dotnope-launch executable (built with the preload library)
+ * @returns {string|null} Path to the launcher or null if not found
+ */
+function findPreloadLauncher() {
+    const possiblePaths = [
+        path.join(__dirname, '../native/preload/dotnope-launch'),
+        '/usr/local/bin/dotnope-launch'
+    ];
+
+    for (const launcherPath of possiblePaths) {
+        if (fs.existsSync(launcherPath)) {
+            return launcherPath;
+        }
+    }
+
+    return null;
+}
+
 /**
  * Check if LD_PRELOAD is currently active with our library
  * @returns {boolean}
@@ -113,9 +798,14 @@ function isPreloadActive() {
 /**
  * Generate environment variables for launching with preload
  * @param {string} pkgPath - Path to package.json
+ * @param {Object} [options]
+ * @param {string} [options.policyFile] - Compile the policy to this file and
+ *                                        pass it via DOTNOPE_POLICY_FILE
+ * @param {string} [options.policySegment] - Publish the policy to this segment
+ *                                           and pass it via DOTNOPE_POLICY_SHM
  * @returns {Object} Environment variables to set
  */
-function generatePreloadEnv(pkgPath) {
+function generatePreloadEnv(pkgPath, options = {}) {
     const preloadPath = findPreloadLibrary();
     if (!preloadPath) {
         throw new Error(
@@ -124,6 +814,20 @@ function generatePreloadEnv(pkgPath) {
         );
     }
 
+    if (options.policySegment) {
+        return {
+            LD_PRELOAD: preloadPath,
+            DOTNOPE_POLICY_SHM: createPolicySegment(options.policySegment, loadWhitelistConfig(pkgPath))
+        };
+    }
+
+    if (options.policyFile) {
+        return {
+            LD_PRELOAD: preloadPath,
+            DOTNOPE_POLICY_FILE: compilePolicyFile(pkgPath, options.policyFile)
+        };
+    }
+
     const policy = generatePolicyFromPackageJson(pkgPath);
 
     return {
@@ -132,10 +836,119 @@ function generatePreloadEnv(pkgPath) {
     };
 }
 
+/**
+ * Reduce an environment to the variables a child can use: everything any
+ * package may read or write, the public tier, the preload essentials and
+ * Node/libc runtime variables. Secrets no package is allowed to see are not inherited at all,
+ * and the child has fewer variables to scan and enumerate.
+ * @param {Object} config - Whitelist config (see loadWhitelistConfig)
+ * @param {Object} [env=process.env] - Environment to reduce
+ * @param {Object} [options]
+ * @param {string[]} [options.keep] - Additional variables to keep (e.g. the application's own)
+ * @param {string[]} [options.publicVars] - Public tier (see loadPublicVars); patterns
+ *   keep only names that do not look like secrets, as at runtime
+ * @returns {Object} The reduced environment; a full copy if any package allows '*'
+ */
+function generateMinimalEnv(config, env = process.env, options = {}) {
+    const policy = generatePolicy(config);
+    if (policy === '*') {
+        return { ...env };
+    }
+
+    const keep = new Set([...ESSENTIAL_VARS, ...RUNTIME_VARS, ...(options.keep || [])]);
+    const patterns = [];
+    for (const name of policy.split(',')) {
+        if (isPattern(name)) {
+            patterns.push(name);
+        } else if (name) {
+            keep.add(name);
+        }
+    }
+    const matcher = patterns.length > 0 ? createMatcher(patterns) : null;
+
+    const publicPatterns = [];
+    for (const name of options.publicVars || []) {
+        if (isPattern(name)) {
+            publicPatterns.push(name);
+        } else {
+            keep.add(name);
+        }
+    }
+    const publicMatcher = publicPatterns.length > 0 ? createMatcher(publicPatterns) : null;
+
+    const minimal = {};
+    for (const [name, value] of Object.entries(env)) {
+        if (keep.has(name) || RUNTIME_PREFIXES.some(prefix => name.startsWith(prefix)) ||
+            (matcher !== null && matcher.match(name).length > 0) ||
+            (publicMatcher !== null && !looksSecret(name) && publicMatcher.match(name).length > 0)) {
+            minimal[name] = value;
+        }
+    }
+    return minimal;
+}
+
+/**
+ * Build a dotnope-launch command line that runs a command under the preload
+ * library with the policy from package.json. The launcher execs the command
+ * in place, so no Node parent stays resident.
+ * @param {string} pkgPath - Path to package.json
+ * @param {string[]} command - Command and its arguments
+ * @param {Object} [options]
+ * @param {string} [options.policyFile] - Compile the policy to this file (-p)
+ * @param {string} [options.policySegment] - Publish the policy to this segment (-s)
+ * @param {string} [options.logFile] - DOTNOPE_LOG destination (-l)
+ * @param {string} [options.launcher] - Launcher path (default: findPreloadLauncher())
+ * @param {string} [options.library] - Preload library path (default: findPreloadLibrary())
+ * @returns {string[]} Launcher argv, starting with the launcher path
+ */
+function generateLaunchCommand(pkgPath, command, options = {}) {
+    const launcher = options.launcher || findPreloadLauncher();
+    const library = options.library || findPreloadLibrary();
+    if (!launcher || !library) {
+        throw new Error(
+            'dotnope: dotnope-launch or libdotnope_preload.so not found!\n' +
+            'Build with: make -C native/preload'
+        );
+    }
+
+    const argv = [launcher, '-L', library];
+
+    if (options.policySegment) {
+        argv.push('-s', createPolicySegment(options.policySegment, loadWhitelistConfig(pkgPath)));
+    } else if (options.policyFile) {
+        argv.push('-p', compilePolicyFile(pkgPath, options.policyFile));
+    } else {
+        argv.push('-P', generatePolicyFromPackageJson(pkgPath));
+    }
+
+    if (options.logFile) {
+        argv.push('-l', options.logFile);
+    }
+
+    argv.push('--', ...command);
+    return argv;
+}
+
 module.exports = {
     generatePolicy,
     generatePolicyFromPackageJson,
+    compilePolicy,
+    compilePolicyFile,
+    readCompiledPolicy,
+    generateBakedPolicyHeader,
+    writeBakedPolicyHeader,
+    loadWhitelistConfig,
+    loadPublicVars,
+    createPolicySegment,
+    publishPolicySegment,
+    parsePreloadStats,
+    readPreloadStats,
+    listPreloadStats,
     findPreloadLibrary,
+    findPreloadLauncher,
+    generateLaunchCommand,
     isPreloadActive,
-    generatePreloadEnv
+    generatePreloadEnv,
+    generateMinimalEnv,
+    ESSENTIAL_VARS
 };
@@ -1,5 +1,9 @@
 'use strict';
 
+// Captured at load: module code could replace the global and receive the
+// handlers (and with them the access checks) of views created later
+const ProxyConstructor = Proxy;
+
 let originalEnv = null;
 let proxyEnv = null;
 let isEnabled = false;
@@ -13,11 +17,125 @@ let proxyInstalledAt = null;
 // Track if we detected that process.env was already captured elsewhere
 let earlyReferenceWarned = false;
 
+// Bumped whenever a write or delete through a proxy adds or removes a key,
+// so cached enumeration results can tell they are stale
+let keySetVersion = 0;
+
+// Value store (envSnapshot): name -> value, read by the proxies instead of
+// the real process.env, whose every read goes through Node's C++
+// interceptor and getenv and allocates a new string. Writes through the
+// proxies update both; changes made elsewhere (native code) are picked up
+// by resyncSnapshot(). Null when reads go to process.env.
+let snapshot = null;
+let snapshotKeys = null;
+
+// Prototype of the real env, for non-variable properties (hasOwnProperty, ...)
+let envPrototype = null;
+
+// Sealed: writes, deletes and defines through the proxies fail as they
+// would on a frozen object
+let sealed = false;
+
+const hasOwn = Object.prototype.hasOwnProperty;
+
+/**
+ * Record a key about to be added (adding=true) or removed
+ * @param {Object} target
+ * @param {string|symbol} prop
+ * @param {boolean} adding
+ */
+function noteKeyChange(target, prop, adding) {
+    const present = snapshot !== null ? snapshot.has(prop) : hasOwn.call(target, prop);
+    if (present !== adding) {
+        keySetVersion++;
+        snapshotKeys = null;
+    }
+}
+
+/**
+ * Bring the snapshot entry for prop up to date after a write or delete
+ * @param {Object} target
+ * @param {string|symbol} prop
+ */
+function syncSnapshotEntry(target, prop) {
+    if (snapshot === null || typeof prop !== 'string') {
+        return;
+    }
+    // Read back, so the stored value is the string Node coerced it to
+    if (hasOwn.call(target, prop)) {
+        snapshot.set(prop, target[prop]);
+    } else {
+        snapshot.delete(prop);
+    }
+}
+
+/**
+ * Read a variable (or an inherited property such as hasOwnProperty)
+ * @param {Object} target
+ * @param {string} prop
+ * @returns {*}
+ */
+function readValue(target, prop) {
+    if (snapshot === null) {
+        return target[prop];
+    }
+    const value = snapshot.get(prop);
+    return value !== undefined ? value : envPrototype[prop];
+}
+
+/**
+ * Check if a variable (or inherited property) exists, as the `in` operator
+ * @param {Object} target
+ * @param {string|symbol} prop
+ * @returns {boolean}
+ */
+function hasValue(target, prop) {
+    if (snapshot === null) {
+        return prop in target;
+    }
+    return snapshot.has(prop) || prop in envPrototype;
+}
+
+/**
+ * Own property descriptor of a variable
+ * @param {Object} target
+ * @param {string|symbol} prop
+ * @returns {Object|undefined}
+ */
+function describeValue(target, prop) {
+    if (snapshot === null) {
+        return Object.getOwnPropertyDescriptor(target, prop);
+    }
+    const value = snapshot.get(prop);
+    if (value === undefined) {
+        return undefined;
+    }
+    return { value, writable: true, enumerable: true, configurable: true };
+}
+
+/**
+ * List every variable name, from the snapshot when there is one
+ * @returns {Array} Keys; do not modify
+ */
+function listEnvKeys() {
+    if (snapshot === null) {
+        return Reflect.ownKeys(originalEnv);
+    }
+    if (snapshotKeys === null) {
+        snapshotKeys = [...snapshot.keys()];
+    }
+    return snapshotKeys;
+}
+
 /**
  * Creates a Proxy wrapper around process.env to intercept all access
  * @param {Function} checkFn - Function called on every env var access
- *                             Signature: checkFn(envVar, operation)
+ *                             Signature: checkFn(envVar, operation, trap)
  *                             operation: 'read' | 'write' | 'delete'
+ *                             trap: 'get' | 'descriptor' for the reads that
+ *                             follow an enumeration, otherwise undefined
+ *                             Returns false to deny silently (reads see the
+ *                             variable as unset, writes and deletes are dropped)
  * @param {Object} options - Protection options
  * @param {boolean} options.protectWrites - Control write operations
  * @param {boolean} options.protectDeletes - Control delete operations
@@ -36,7 +154,7 @@ function createEnvProxy(checkFn, options = {}) {
     };
     originalEnv = process.env;
 
-    proxyEnv = new Proxy(originalEnv, {
+    proxyEnv = new ProxyConstructor(originalEnv, {
         get(target, prop, receiver) {
             // Skip symbols and internal properties
             if (typeof prop === 'symbol') {
@@ -48,73 +166,90 @@ function createEnvProxy(checkFn, options = {}) {
                 return Reflect.get(target, prop, receiver);
             }
 
-            // Check access if enabled
-            if (isEnabled && checkAccessFn) {
-                checkAccessFn(String(prop), 'read');
+            // Check access if enabled; a silent denial reads as unset
+            if (isEnabled && checkAccessFn && checkAccessFn(String(prop), 'read', 'get') === false) {
+                return undefined;
             }
 
-            return target[prop];
+            return readValue(target, prop);
         },
 
         set(target, prop, value) {
+            if (sealed) {
+                return false;
+            }
             // Check write access if enabled and protectWrites is true
             if (isEnabled && checkAccessFn && proxyOptions.protectWrites) {
-                if (typeof prop === 'string') {
-                    checkAccessFn(prop, 'write');
+                if (typeof prop === 'string' && checkAccessFn(prop, 'write') === false) {
+                    return true; // Silently dropped
                 }
             }
+            noteKeyChange(target, prop, true);
             target[prop] = value;
+            syncSnapshotEntry(target, prop);
             return true;
         },
 
         has(target, prop) {
             // Intercept 'in' operator usage
-            if (isEnabled && checkAccessFn && typeof prop === 'string') {
-                checkAccessFn(prop, 'read');
+            if (isEnabled && checkAccessFn && typeof prop === 'string' && checkAccessFn(prop, 'read') === false) {
+                return false;
             }
-            return prop in target;
+            return hasValue(target, prop);
         },
 
         deleteProperty(target, prop) {
+            if (sealed) {
+                return false;
+            }
             // Check delete access if enabled and protectDeletes is true
             if (isEnabled && checkAccessFn && proxyOptions.protectDeletes) {
-                if (typeof prop === 'string') {
-                    checkAccessFn(prop, 'delete');
+                if (typeof prop === 'string' && checkAccessFn(prop, 'delete') === false) {
+                    return true; // Silently dropped
                 }
             }
+            noteKeyChange(target, prop, false);
             delete target[prop];
+            syncSnapshotEntry(target, prop);
             return true;
         },
 
         ownKeys(target) {
             // Filter enumeration if protectEnumeration is enabled
             if (isEnabled && proxyOptions.protectEnumeration && filterKeysFn) {
-                const allKeys = Reflect.ownKeys(target);
-                // Filter to only allowed keys for the caller
-                const filteredKeys = filterKeysFn(allKeys);
+                // Filter to only allowed keys for the caller; the filter
+                // lists the keys itself only when it must
+                const filteredKeys = filterKeysFn(listEnvKeys);
                 if (filteredKeys !== null) {
                     return filteredKeys;
                 }
             }
-            return Reflect.ownKeys(target);
+            return listEnvKeys();
         },
 
         getOwnPropertyDescriptor(target, prop) {
             // Intercept property descriptor access
-            if (isEnabled && checkAccessFn && typeof prop === 'string') {
-                checkAccessFn(prop, 'read');
+            if (isEnabled && checkAccessFn && typeof prop === 'string' &&
+                checkAccessFn(prop, 'read', 'descriptor') === false) {
+                return undefined;
             }
-            return Object.getOwnPropertyDescriptor(target, prop);
+            return describeValue(target, prop);
         },
 
         defineProperty(target, prop, descriptor) {
+            if (sealed) {
+                return false;
+            }
             // Check write access for defineProperty (it's effectively a write)
             if (isEnabled && checkAccessFn && proxyOptions.protectWrites) {
-                if (typeof prop === 'string') {
-                    checkAccessFn(prop, 'write');
+                if (typeof prop === 'string' && checkAccessFn(prop, 'write') === false) {
+                    return false;
                 }
             }
-            return Object.defineProperty(target, prop, descriptor);
+            noteKeyChange(target, prop, true);
+            Object.defineProperty(target, prop, descriptor);
+            syncSnapshotEntry(target, prop);
+            return true;
         }
     });
 
@@ -133,6 +268,118 @@ function createEnvProxy(checkFn, options = {}) {
     // direct access to the original object.
 }
 
+/**
+ * Creates a process.env view bound to one caller, for per-module injection
+ * (see module-scope.js). Checks receive no stack-derived caller: the view
+ * itself is the attribution.
+ * Must be called after createEnvProxy().
+ * @param {Function} checkFn - checkFn(envVar, operation), throws or returns false on deny
+ * @param {Function} filterFn - filterFn(listKeys) => filtered keys or null
+ * @returns {Proxy} The bound view
+ */
+function createScopedEnv(checkFn, filterFn) {
+    if (!originalEnv) {
+        throw new Error('strictenv: Proxy not created');
+    }
+
+    const options = proxyOptions;
+
+    return new ProxyConstructor(originalEnv, {
+        get(target, prop, receiver) {
+            if (typeof prop === 'symbol' || prop === 'inspect') {
+                return Reflect.get(target, prop, receiver);
+            }
+            if (isEnabled && checkFn(prop, 'read') === false) {
+                return undefined;
+            }
+            return readValue(target, prop);
+        },
+
+        set(target, prop, value) {
+            if (sealed) {
+                return false;
+            }
+            if (isEnabled && options.protectWrites && typeof prop === 'string' && checkFn(prop, 'write') === false) {
+                return true;
+            }
+            noteKeyChange(target, prop, true);
+            target[prop] = value;
+            syncSnapshotEntry(target, prop);
+            return true;
+        },
+
+        has(target, prop) {
+            if (isEnabled && typeof prop === 'string' && checkFn(prop, 'read') === false) {
+                return false;
+            }
+            return hasValue(target, prop);
+        },
+
+        deleteProperty(target, prop) {
+            if (sealed) {
+                return false;
+            }
+            if (isEnabled && options.protectDeletes && typeof prop === 'string' && checkFn(prop, 'delete') === false) {
+                return true;
+            }
+            noteKeyChange(target, prop, false);
+            delete target[prop];
+            syncSnapshotEntry(target, prop);
+            return true;
+        },
+
+        ownKeys() {
+            if (isEnabled && options.protectEnumeration) {
+                const filteredKeys = filterFn(listEnvKeys);
+                if (filteredKeys !== null) {
+                    return filteredKeys;
+                }
+            }
+            return listEnvKeys();
+        },
+
+        getOwnPropertyDescriptor(target, prop) {
+            if (isEnabled && typeof prop === 'string' && checkFn(prop, 'read') === false) {
+                return undefined;
+            }
+            return describeValue(target, prop);
+        },
+
+        defineProperty(target, prop, descriptor) {
+            if (sealed) {
+                return false;
+            }
+            if (isEnabled && options.protectWrites && typeof prop === 'string' && checkFn(prop, 'write') === false) {
+                return false;
+            }
+            noteKeyChange(target, prop, true);
+            Object.defineProperty(target, prop, descriptor);
+            syncSnapshotEntry(target, prop);
+            return true;
+        }
+    });
+}
+
+/**
+ * Creates a process view whose `env` is the given scoped env; everything
+ * else is the real process
+ * @param {Proxy} scopedEnv - From createScopedEnv()
+ * @returns {Proxy}
+ */
+function createScopedProcess(scopedEnv) {
+    return new ProxyConstructor(process, {
+        get(target, prop) {
+            if (prop === 'env') {
+                return scopedEnv;
+            }
+            // Accessors run against the real process; methods are returned
+            // unbound (process.hrtime.bigint and the like must survive) and
+            // their reads through `this` reach the target anyway
+            return Reflect.get(target, prop, target);
+        }
+    });
+}
+
 /**
  * Enable strict environment checking
  */
@@ -158,18 +405,80 @@ function restore() {
         checkAccessFn = null;
         filterKeysFn = null;
         proxyOptions = null;
+        snapshot = null;
+        snapshotKeys = null;
+        envPrototype = null;
+        sealed = false;
+    }
+}
+
+/**
+ * Serve reads from a snapshot of process.env (see `snapshot`).
+ * Must be called after createEnvProxy().
+ */
+function enableSnapshot() {
+    if (!originalEnv) {
+        throw new Error('strictenv: Proxy not created');
+    }
+    envPrototype = Object.getPrototypeOf(originalEnv) || Object.prototype;
+    resyncSnapshot();
+}
+
+/**
+ * Rebuild the snapshot from the real process.env, picking up changes made
+ * outside the proxies (native code, or before the snapshot was taken)
+ * @returns {boolean} false if there is no snapshot or the env is sealed
+ */
+function resyncSnapshot() {
+    if (envPrototype === null || sealed && snapshot !== null) {
+        return false;
+    }
+
+    const next = new Map();
+    for (const key of Object.keys(originalEnv)) {
+        next.set(key, originalEnv[key]);
     }
+    snapshot = next;
+    snapshotKeys = null;
+    keySetVersion++;
+    return true;
+}
+
+/**
+ * Make every write, delete and define through the proxies fail, as on a
+ * frozen object (a TypeError in strict mode code). Irreversible until
+ * restore(); a snapshot is no longer resynced.
+ */
+function seal() {
+    sealed = true;
+}
+
+/**
+ * Check if the environment is sealed
+ * @returns {boolean}
+ */
+function isSealed() {
+    return sealed;
 }
 
 /**
  * Set the function used to filter ownKeys results
- * @param {Function} filterFn - Function that takes all keys and returns filtered keys
- *                              Returns null to skip filtering
+ * @param {Function} filterFn - Function that takes a function listing every key
+ *                              and returns the keys the caller may see, or null
+ *                              to skip filtering
  */
 function setFilterKeysFn(filterFn) {
     filterKeysFn = filterFn;
 }
 
+/**
+ * Get the key set version (see noteKeyChange)
+ * @returns {number}
+ */
+function getKeySetVersion() {
+    return keySetVersion;
+}
+
 /**
  * Check if strict mode is currently enabled
  */
@@ -199,10 +508,18 @@ function getProxyStatus() {
 
 module.exports = {
     createEnvProxy,
+    createScopedEnv,
+    createScopedProcess,
     enable,
     disable,
     restore,
+    enableSnapshot,
+    resyncSnapshot,
+    seal,
+    isSealed,
+    listEnvKeys,
     setFilterKeysFn,
+    getKeySetVersion,
     isStrictModeEnabled,
     getProxyInstalledAt,
     getProxyStatus
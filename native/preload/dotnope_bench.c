@@ -0,0 +1,265 @@
+/**
+ * dotnope_bench.c - Microbenchmark and stress harness for libdotnope_preload.so
+ *
+ * Standalone program; it does not link against the preload library. Run it
+ * once plainly for a libc baseline and again under LD_PRELOAD to measure
+ * what interposition costs (make bench does both, for several policy sizes).
+ *
+ * Cases:
+ *   getenv-allowed  getenv() of one allowed variable (decision cache hits)
+ *   getenv-denied   getenv() of one denied variable
+ *   getenv-rotate   getenv() cycling through 256 distinct name buffers per
+ *                   thread, which defeats the per-thread decision cache and
+ *                   exercises the policy lookup itself
+ *   setenv          setenv() of an allowed variable
+ *   open            open() + close() of /dev/null
+ *   fopen           fopen() + fclose() of /dev/null
+ *   spawn           posix_spawn() of /bin/true with environ, then waitpid()
+ *
+ * Every case runs at each requested thread count. Output is one row per
+ * (case, threads): per-thread latency in ns/op, aggregate throughput and
+ * scaling relative to one thread.
+ *
+ * Usage: dotnope_bench [-l label] [-t 1,2,4,8] [-n iterations] [-c case]
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define MAX_THREADS 256
+#define ROTATE_NAMES 256
+#define ROTATE_NAME_LEN 32
+
+typedef void (*bench_fn)(long iterations, int tid);
+
+typedef struct {
+    const char* name;
+    bench_fn fn;
+    int iteration_divisor;      /* syscall-bound cases run fewer iterations */
+} bench_case;
+
+typedef struct {
+    bench_fn fn;
+    long iterations;
+    int tid;
+    pthread_barrier_t* barrier;
+    double elapsed_ns;
+} worker_args;
+
+extern char** environ;
+
+static volatile uintptr_t sink;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void bench_getenv_allowed(long iterations, int tid) {
+    (void)tid;
+    uintptr_t acc = 0;
+    for (long i = 0; i < iterations; i++) {
+        acc += (uintptr_t)getenv("BENCH_VAR_0");
+    }
+    sink += acc;
+}
+
+static void bench_getenv_denied(long iterations, int tid) {
+    (void)tid;
+    uintptr_t acc = 0;
+    for (long i = 0; i < iterations; i++) {
+        acc += (uintptr_t)getenv("BENCH_SECRET");
+    }
+    sink += acc;
+}
+
+static void bench_getenv_rotate(long iterations, int tid) {
+    (void)tid;
+    /* Per-thread buffers so every thread presents its own name pointers */
+    char (*names)[ROTATE_NAME_LEN] = malloc(sizeof(*names) * ROTATE_NAMES);
+    if (!names) return;
+    for (int i = 0; i < ROTATE_NAMES; i++) {
+        snprintf(names[i], ROTATE_NAME_LEN, "BENCH_VAR_%d", i);
+    }
+
+    uintptr_t acc = 0;
+    for (long i = 0; i < iterations; i++) {
+        acc += (uintptr_t)getenv(names[i % ROTATE_NAMES]);
+    }
+    sink += acc;
+    free(names);
+}
+
+static void bench_setenv(long iterations, int tid) {
+    (void)tid;
+    uintptr_t acc = 0;
+    for (long i = 0; i < iterations; i++) {
+        acc += (uintptr_t)setenv("BENCH_VAR_1", "1", 1);
+    }
+    sink += acc;
+}
+
+static void bench_open(long iterations, int tid) {
+    (void)tid;
+    for (long i = 0; i < iterations; i++) {
+        int fd = open("/dev/null", O_RDONLY);
+        if (fd >= 0) close(fd);
+    }
+}
+
+static void bench_fopen(long iterations, int tid) {
+    (void)tid;
+    for (long i = 0; i < iterations; i++) {
+        FILE* f = fopen("/dev/null", "r");
+        if (f) fclose(f);
+    }
+}
+
+static void bench_spawn(long iterations, int tid) {
+    (void)tid;
+    char* argv[] = { "true", NULL };
+    for (long i = 0; i < iterations; i++) {
+        pid_t pid;
+        if (posix_spawn(&pid, "/bin/true", NULL, NULL, argv, environ) == 0) {
+            waitpid(pid, NULL, 0);
+        }
+    }
+}
+
+static const bench_case cases[] = {
+    { "getenv-allowed", bench_getenv_allowed, 1 },
+    { "getenv-denied", bench_getenv_denied, 1 },
+    { "getenv-rotate", bench_getenv_rotate, 1 },
+    { "setenv", bench_setenv, 4 },
+    { "open", bench_open, 10 },
+    { "fopen", bench_fopen, 10 },
+    { "spawn", bench_spawn, 2000 },
+};
+
+static void* worker(void* arg) {
+    worker_args* args = (worker_args*)arg;
+
+    pthread_barrier_wait(args->barrier);
+    double start = now_ns();
+    args->fn(args->iterations, args->tid);
+    args->elapsed_ns = now_ns() - start;
+
+    return NULL;
+}
+
+/**
+ * Run one case on the given number of threads.
+ * Returns aggregate throughput in ops/sec; *latency receives the mean
+ * per-thread ns/op.
+ */
+static double run_case(const bench_case* bc, int threads, long iterations, double* latency) {
+    pthread_t tids[MAX_THREADS];
+    worker_args args[MAX_THREADS];
+    pthread_barrier_t barrier;
+
+    pthread_barrier_init(&barrier, NULL, (unsigned)threads + 1);
+    for (int i = 0; i < threads; i++) {
+        args[i] = (worker_args){ bc->fn, iterations, i, &barrier, 0 };
+        pthread_create(&tids[i], NULL, worker, &args[i]);
+    }
+
+    double start = now_ns();
+    pthread_barrier_wait(&barrier);
+    double slowest = 0;
+    double total = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        total += args[i].elapsed_ns;
+        if (args[i].elapsed_ns > slowest) slowest = args[i].elapsed_ns;
+    }
+    double wall = now_ns() - start;
+    pthread_barrier_destroy(&barrier);
+
+    if (slowest > wall) wall = slowest;
+    *latency = total / threads / (double)iterations;
+    return (double)iterations * threads / (wall / 1e9);
+}
+
+static int parse_threads(const char* spec, int* out, int max) {
+    int count = 0;
+    char* copy = strdup(spec);
+    if (!copy) return 0;
+
+    for (char* tok = strtok(copy, ","); tok && count < max; tok = strtok(NULL, ",")) {
+        int n = atoi(tok);
+        if (n >= 1 && n <= MAX_THREADS) out[count++] = n;
+    }
+    free(copy);
+    return count;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "Usage: %s [-l label] [-t 1,2,4,8] [-n iterations] [-c case]\n", argv0);
+    fprintf(stderr, "Cases:");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        fprintf(stderr, " %s", cases[i].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv) {
+    const char* label = "baseline";
+    const char* only = NULL;
+    long iterations = 1000000;
+    int threads[32];
+    int thread_count = parse_threads("1,2,4,8", threads, 32);
+    int opt;
+
+    while ((opt = getopt(argc, argv, "l:t:n:c:h")) != -1) {
+        switch (opt) {
+            case 'l': label = optarg; break;
+            case 't': thread_count = parse_threads(optarg, threads, 32); break;
+            case 'n': iterations = atol(optarg); break;
+            case 'c': only = optarg; break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (thread_count == 0 || iterations <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    /* getenv("LD_PRELOAD") is itself filtered under the preload, so the
+     * label is the only reliable record of the configuration */
+    printf("# %s\n", label);
+    printf("%-16s %-14s %7s %12s %14s %8s\n", "label", "case", "threads", "ns/op", "ops/sec", "scaling");
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        const bench_case* bc = &cases[c];
+        if (only && strcmp(only, bc->name) != 0) continue;
+
+        long n = iterations / bc->iteration_divisor;
+        if (n < 1) n = 1;
+
+        /* Warm up caches, lazy symbol binding and the preload's own state */
+        double latency;
+        run_case(bc, 1, n / 10 + 1, &latency);
+
+        double single = 0;
+        for (int t = 0; t < thread_count; t++) {
+            double throughput = run_case(bc, threads[t], n, &latency);
+            if (t == 0) single = throughput / threads[t];
+
+            printf("%-16s %-14s %7d %12.1f %14.0f %7.2fx\n",
+                   label, bc->name, threads[t], latency, throughput,
+                   single > 0 ? throughput / single : 0.0);
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+/**
+ * dotnope_launch.c - Minimal launcher for running a command under libdotnope_preload.so
+ *
+ * Validates the policy, adds the library to LD_PRELOAD, sets the policy
+ * variable, and execs the command in place. Nothing stays resident: the
+ * command inherits the launcher's pid, so exit codes and signals need no
+ * forwarding (unlike dotnope-run, which keeps a Node parent around).
+ *
+ * Usage:
+ *   dotnope-launch [options] [--] command [args...]
+ *
+ * Options:
+ *   -p file   compiled policy (dotnope-run --compile-policy), validated here
+ *             and passed as DOTNOPE_POLICY_FILE
+ *   -s file   policy segment (dotnope-run --policy-shm), passed as
+ *             DOTNOPE_POLICY_SHM
+ *   -P list   comma-separated policy string, passed as DOTNOPE_POLICY
+ *   -L lib    preload library (default: libdotnope_preload.so next to this
+ *             executable)
+ *   -l dest   DOTNOPE_LOG (1, stderr or a path)
+ *
+ * Exactly one policy option is required. Policy variables of lower
+ * precedence are removed so the one given is the one the library uses.
+ * Exit status: 127 if the command cannot be executed, 2 for usage errors,
+ * 1 for an unusable policy or library.
+ */
+
+/* _GNU_SOURCE is defined via CFLAGS in Makefile */
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dotnope_policy.h"
+
+#define PRELOAD_NAME "libdotnope_preload.so"
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s (-p policy.bin | -s segment | -P VAR1,VAR2) [-L lib.so] [-l log] [--] command [args...]\n",
+            argv0);
+}
+
+/**
+ * Map and validate a compiled policy file. Returns NULL or an error message.
+ */
+static const char* check_policy_file(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return strerror(errno);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return "empty or unreadable file";
+    }
+
+    void* image = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) return strerror(errno);
+
+    const char* error = dnp_policy_validate(image, (size_t)st.st_size);
+    munmap(image, (size_t)st.st_size);
+    return error;
+}
+
+/**
+ * Check a policy segment's header; the slots are validated by the library
+ * on every reload anyway. Returns NULL or an error message.
+ */
+static const char* check_policy_segment(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return strerror(errno);
+
+    dnp_segment_header header;
+    ssize_t n = read(fd, &header, sizeof(header));
+    close(fd);
+
+    if (n != (ssize_t)sizeof(header)) return "file too small";
+    if (memcmp(header.magic, DNP_SEGMENT_MAGIC, DNP_POLICY_MAGIC_LEN) != 0) return "bad magic";
+    if (header.version != DNP_SEGMENT_VERSION) return "unsupported version";
+    return NULL;
+}
+
+/**
+ * Default library: libdotnope_preload.so in the launcher's own directory
+ */
+static int default_library(char* out, size_t size) {
+    char self[PATH_MAX];
+    ssize_t n = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (n <= 0) return -1;
+    self[n] = '\0';
+
+    char* slash = strrchr(self, '/');
+    if (!slash) return -1;
+    *slash = '\0';
+
+    int written = snprintf(out, size, "%s/%s", self, PRELOAD_NAME);
+    return written > 0 && (size_t)written < size ? 0 : -1;
+}
+
+/**
+ * Whether an LD_PRELOAD value already lists the library. The loader
+ * accepts both ':' and whitespace as separators.
+ */
+static int preload_lists(const char* preload, const char* library) {
+    size_t len = strlen(library);
+    const char* p = preload;
+    while (*p) {
+        size_t n = strcspn(p, ": \t");
+        if (n == len && memcmp(p, library, len) == 0) return 1;
+        p += n;
+        if (*p) p++;
+    }
+    return 0;
+}
+
+/**
+ * Put the library first in LD_PRELOAD, keeping whatever the caller had
+ * preloaded (sanitizers, profilers). Returns -1 if the value is too long.
+ */
+static int set_preload(const char* library) {
+    const char* existing = getenv("LD_PRELOAD");
+    if (!existing || !*existing) return setenv("LD_PRELOAD", library, 1);
+    if (preload_lists(existing, library)) return 0;
+
+    char value[PATH_MAX * 4];
+    int written = snprintf(value, sizeof(value), "%s:%s", library, existing);
+    if (written < 0 || (size_t)written >= sizeof(value)) return -1;
+    return setenv("LD_PRELOAD", value, 1);
+}
+
+int main(int argc, char** argv) {
+    const char* policy_file = NULL;
+    const char* policy_segment = NULL;
+    const char* policy_list = NULL;
+    const char* library = NULL;
+    const char* log_dest = NULL;
+    int opt;
+
+    /* '+': stop at the first non-option, which starts the command */
+    while ((opt = getopt(argc, argv, "+p:s:P:L:l:h")) != -1) {
+        switch (opt) {
+            case 'p': policy_file = optarg; break;
+            case 's': policy_segment = optarg; break;
+            case 'P': policy_list = optarg; break;
+            case 'L': library = optarg; break;
+            case 'l': log_dest = optarg; break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    if (optind >= argc || (!!policy_file + !!policy_segment + !!policy_list) != 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char library_path[PATH_MAX];
+    if (!library) {
+        if (default_library(library_path, sizeof(library_path)) != 0) {
+            fprintf(stderr, "[dotnope-launch] Cannot locate %s; pass -L\n", PRELOAD_NAME);
+            return 1;
+        }
+        library = library_path;
+    }
+
+    /* The dynamic loader silently skips a missing LD_PRELOAD entry, which
+       would run the command unprotected */
+    char resolved_library[PATH_MAX];
+    if (!realpath(library, resolved_library) || access(resolved_library, R_OK) != 0) {
+        fprintf(stderr, "[dotnope-launch] Preload library %s: %s\n", library, strerror(errno));
+        return 1;
+    }
+
+    /* Clear every policy source, then set the one given: the library prefers
+       a segment over a file over a string */
+    unsetenv("DOTNOPE_POLICY_SHM");
+    unsetenv("DOTNOPE_POLICY_FILE");
+    unsetenv("DOTNOPE_POLICY");
+
+    char resolved_policy[PATH_MAX];
+    if (policy_file || policy_segment) {
+        const char* path = policy_file ? policy_file : policy_segment;
+        const char* error = policy_file ? check_policy_file(path) : check_policy_segment(path);
+        if (error) {
+            fprintf(stderr, "[dotnope-launch] Invalid policy %s: %s\n", path, error);
+            return 1;
+        }
+        /* The command may change directory before the library loads it */
+        if (!realpath(path, resolved_policy)) {
+            fprintf(stderr, "[dotnope-launch] Policy %s: %s\n", path, strerror(errno));
+            return 1;
+        }
+        setenv(policy_file ? "DOTNOPE_POLICY_FILE" : "DOTNOPE_POLICY_SHM", resolved_policy, 1);
+    } else {
+        setenv("DOTNOPE_POLICY", policy_list, 1);
+    }
+
+    if (log_dest) {
+        setenv("DOTNOPE_LOG", log_dest, 1);
+    }
+    if (set_preload(resolved_library) != 0) {
+        fprintf(stderr, "[dotnope-launch] Cannot add %s to LD_PRELOAD\n", resolved_library);
+        return 1;
+    }
+
+    execvp(argv[optind], &argv[optind]);
+    fprintf(stderr, "[dotnope-launch] Cannot execute %s: %s\n", argv[optind], strerror(errno));
+    return 127;
+}
@@ -0,0 +1,226 @@
+/**
+ * dotnope_policy.h - Compiled binary policy format for libdotnope_preload.so
+ *
+ * A compiled policy is a single read-only image produced by
+ * lib/preload-generator.js (compilePolicy) and mapped in place by the
+ * preload library via DOTNOPE_POLICY_FILE. All integers are little-endian
+ * uint32 values; all offsets are relative to the start of the image.
+ *
+ * Layout:
+ *   dnp_policy_header
+ *   dnp_policy_var[var_count]          (sorted by name)
+ *   uint32_t buckets[bucket_count]     (0 = empty, otherwise var index + 1)
+ *   dnp_policy_package[package_count]  (sorted by name)
+ *   uint32_t members[]                 (var indices referenced by packages)
+ *   char strings[strings_size]         (NUL-terminated names)
+ *
+ * The hash table uses FNV-1a over the variable name with linear probing.
+ * The checksum is FNV-1a over every byte following the header.
+ *
+ * A policy segment (DOTNOPE_POLICY_SHM) wraps two policy images for hot
+ * reload. A single controller writes the next image into the inactive
+ * slot and then bumps the generation; the active slot is generation & 1.
+ * Readers sample the generation before and after a lookup and retry if it
+ * changed (seqlock), so lookups never take a lock:
+ *
+ *   dnp_segment_header (padded to DNP_SEGMENT_HEADER_SIZE)
+ *   slot 0: policy image (slot_size bytes)
+ *   slot 1: policy image (slot_size bytes)
+ */
+
+#ifndef DOTNOPE_POLICY_H
+#define DOTNOPE_POLICY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DNP_POLICY_MAGIC "DNPOLICY"
+#define DNP_POLICY_MAGIC_LEN 8
+#define DNP_POLICY_VERSION 1
+
+#define DNP_SEGMENT_MAGIC "DNPSEGMT"
+#define DNP_SEGMENT_VERSION 1
+#define DNP_SEGMENT_HEADER_SIZE 64
+
+/* Header flags */
+#define DNP_POLICY_FLAG_ALLOW_ALL 0x1u
+
+/* Package flags */
+#define DNP_PACKAGE_FLAG_WILDCARD 0x1u
+
+#define DNP_FNV_OFFSET 2166136261u
+#define DNP_FNV_PRIME 16777619u
+
+typedef struct {
+    char magic[DNP_POLICY_MAGIC_LEN];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t total_size;
+    uint32_t checksum;
+    uint32_t var_count;
+    uint32_t bucket_count;
+    uint32_t package_count;
+    uint32_t vars_offset;
+    uint32_t buckets_offset;
+    uint32_t packages_offset;
+    uint32_t members_offset;
+    uint32_t member_count;
+    uint32_t strings_offset;
+    uint32_t strings_size;
+} dnp_policy_header;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t name_offset;   /* relative to strings_offset */
+    uint32_t name_len;
+    uint32_t reserved;
+} dnp_policy_var;
+
+typedef struct {
+    uint32_t name_offset;   /* relative to strings_offset */
+    uint32_t name_len;
+    uint32_t first_member;  /* index into members[] */
+    uint32_t member_count;
+    uint32_t flags;
+    uint32_t reserved;
+} dnp_policy_package;
+
+typedef struct {
+    char magic[DNP_POLICY_MAGIC_LEN];
+    uint32_t version;
+    uint32_t slot_size;
+    uint32_t generation;    /* written last by the controller */
+    uint32_t reserved[11];
+} dnp_segment_header;
+
+static inline uint32_t dnp_hash_update(uint32_t hash, const void* data, size_t len) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= DNP_FNV_PRIME;
+    }
+    return hash;
+}
+
+static inline uint32_t dnp_hash(const void* data, size_t len) {
+    return dnp_hash_update(DNP_FNV_OFFSET, data, len);
+}
+
+/**
+ * Check that a range lies within an image of the given size
+ */
+static inline int dnp_range_ok(uint32_t offset, uint64_t len, size_t size) {
+    return (uint64_t)offset + len <= (uint64_t)size;
+}
+
+/**
+ * Validate a compiled policy image.
+ * Returns NULL on success or a static string describing the problem.
+ * After successful validation every offset in the image is in bounds.
+ */
+static inline const char* dnp_policy_validate(const void* image, size_t size) {
+    const unsigned char* base = (const unsigned char*)image;
+    const dnp_policy_header* hdr = (const dnp_policy_header*)image;
+
+    if (size < sizeof(dnp_policy_header)) return "file too small";
+    if (memcmp(hdr->magic, DNP_POLICY_MAGIC, DNP_POLICY_MAGIC_LEN) != 0) return "bad magic";
+    if (hdr->version != DNP_POLICY_VERSION) return "unsupported version";
+    if (hdr->total_size != size) return "size mismatch";
+
+    if (dnp_hash(base + sizeof(dnp_policy_header), size - sizeof(dnp_policy_header)) != hdr->checksum) {
+        return "checksum mismatch";
+    }
+
+    if (hdr->bucket_count == 0 || (hdr->bucket_count & (hdr->bucket_count - 1)) != 0 ||
+        hdr->bucket_count <= hdr->var_count) {
+        return "bad bucket count";
+    }
+
+    if ((hdr->vars_offset | hdr->buckets_offset | hdr->packages_offset | hdr->members_offset) & 3u) {
+        return "misaligned section";
+    }
+
+    if (!dnp_range_ok(hdr->vars_offset, (uint64_t)hdr->var_count * sizeof(dnp_policy_var), size) ||
+        !dnp_range_ok(hdr->buckets_offset, (uint64_t)hdr->bucket_count * sizeof(uint32_t), size) ||
+        !dnp_range_ok(hdr->packages_offset, (uint64_t)hdr->package_count * sizeof(dnp_policy_package), size) ||
+        !dnp_range_ok(hdr->members_offset, (uint64_t)hdr->member_count * sizeof(uint32_t), size) ||
+        !dnp_range_ok(hdr->strings_offset, hdr->strings_size, size)) {
+        return "section out of bounds";
+    }
+
+    const char* strings = (const char*)(base + hdr->strings_offset);
+    const dnp_policy_var* vars = (const dnp_policy_var*)(base + hdr->vars_offset);
+    for (uint32_t i = 0; i < hdr->var_count; i++) {
+        if (!dnp_range_ok(vars[i].name_offset, (uint64_t)vars[i].name_len + 1, hdr->strings_size) ||
+            strings[vars[i].name_offset + vars[i].name_len] != '\0') {
+            return "bad variable name";
+        }
+    }
+
+    const uint32_t* buckets = (const uint32_t*)(base + hdr->buckets_offset);
+    for (uint32_t i = 0; i < hdr->bucket_count; i++) {
+        if (buckets[i] > hdr->var_count) return "bad bucket entry";
+    }
+
+    const dnp_policy_package* packages = (const dnp_policy_package*)(base + hdr->packages_offset);
+    const uint32_t* members = (const uint32_t*)(base + hdr->members_offset);
+    for (uint32_t i = 0; i < hdr->package_count; i++) {
+        if (!dnp_range_ok(packages[i].name_offset, (uint64_t)packages[i].name_len + 1, hdr->strings_size) ||
+            !dnp_range_ok(packages[i].first_member, packages[i].member_count, hdr->member_count)) {
+            return "bad package entry";
+        }
+    }
+    for (uint32_t i = 0; i < hdr->member_count; i++) {
+        if (members[i] >= hdr->var_count) return "bad package member";
+    }
+
+    return NULL;
+}
+
+/**
+ * Look up a variable name in a policy image of the given size.
+ * Returns 1 if the variable is listed, 0 otherwise.
+ *
+ * Every access is bounds-checked against size, so this is also safe on a
+ * segment slot that a controller rewrites concurrently; such a lookup may
+ * return a wrong answer, which the caller's generation re-check discards.
+ */
+static inline int dnp_policy_contains(const void* image, size_t size, const char* name, size_t len) {
+    const unsigned char* base = (const unsigned char*)image;
+    dnp_policy_header hdr;
+
+    if (size < sizeof(hdr)) return 0;
+    memcpy(&hdr, image, sizeof(hdr));
+
+    uint32_t mask = hdr.bucket_count - 1;
+    if (hdr.bucket_count == 0 || (hdr.bucket_count & mask) != 0 ||
+        ((hdr.vars_offset | hdr.buckets_offset) & 3u) ||
+        !dnp_range_ok(hdr.vars_offset, (uint64_t)hdr.var_count * sizeof(dnp_policy_var), size) ||
+        !dnp_range_ok(hdr.buckets_offset, (uint64_t)hdr.bucket_count * sizeof(uint32_t), size) ||
+        !dnp_range_ok(hdr.strings_offset, hdr.strings_size, size)) {
+        return 0;
+    }
+
+    const dnp_policy_var* vars = (const dnp_policy_var*)(base + hdr.vars_offset);
+    const uint32_t* buckets = (const uint32_t*)(base + hdr.buckets_offset);
+    const char* strings = (const char*)(base + hdr.strings_offset);
+    uint32_t hash = dnp_hash(name, len);
+
+    for (uint32_t probe = 0, i = hash & mask; probe <= mask; probe++, i = (i + 1) & mask) {
+        uint32_t slot = buckets[i];
+        if (slot == 0 || slot > hdr.var_count) return 0;
+
+        dnp_policy_var var;
+        memcpy(&var, &vars[slot - 1], sizeof(var));
+        if (var.hash == hash && var.name_len == len &&
+            dnp_range_ok(var.name_offset, len, hdr.strings_size) &&
+            memcmp(strings + var.name_offset, name, len) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+#endif /* DOTNOPE_POLICY_H */
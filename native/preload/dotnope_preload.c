@@ -1,15 +1,27 @@
 /**
  * dotnope_preload.c - LD_PRELOAD library for libc getenv interposition
  *
- * This library intercepts getenv/setenv/unsetenv calls from native code,
+ * This library intercepts getenv/setenv/unsetenv/putenv calls from native code,
  * allowing dotnope to control environment variable access even from
- * C/C++ native addons.
+ * C/C++ native addons. The environment handed to child processes through
+ * execve/execv/execvp/execvpe/posix_spawn/posix_spawnp is filtered against
+ * the same policy.
  *
  * Usage:
  *   LD_PRELOAD=/path/to/libdotnope_preload.so node app.js
  *
- * Configuration is read from DOTNOPE_POLICY environment variable or
- * from a Unix domain socket for dynamic policy updates.
+ * Building with -DDOTNOPE_NO_FILE_HOOKS (make scrub) leaves open() and
+ * friends alone entirely; /proc/<pid>/environ is covered by scrubbing the
+ * original environment block at startup instead, which is then always on.
+ *
+ * Building with -DDOTNOPE_BAKED_POLICY (make baked) compiles the policy from
+ * a generated dotnope_baked_policy.h into read-only data; the runtime policy
+ * variables below are then ignored.
+ *
+ * Otherwise configuration is read from a shared policy segment that a controller can
+ * rewrite for dynamic policy updates (DOTNOPE_POLICY_SHM), from a compiled
+ * policy file (DOTNOPE_POLICY_FILE), or from the DOTNOPE_POLICY environment
+ * variable.
  */
 
 /* _GNU_SOURCE is defined via CFLAGS in Makefile */
@@ -21,22 +33,41 @@
 #include <pthread.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <spawn.h>
 #include <stdarg.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+
+#include "dotnope_policy.h"
+#include "dotnope_stats.h"
+#ifdef DOTNOPE_BAKED_POLICY
+#include "dotnope_baked_policy.h"
+#endif
 
 /* Original libc functions */
 static char* (*real_getenv)(const char*) = NULL;
 static int (*real_setenv)(const char*, const char*, int) = NULL;
 static int (*real_unsetenv)(const char*) = NULL;
+static int (*real_putenv)(char*) = NULL;
+static int (*real_clearenv)(void) = NULL;
 
-/* File access functions for /proc/*/environ protection */
+/* File access functions for /proc/<pid>/environ protection */
 static int (*real_open)(const char*, int, ...) = NULL;
 static int (*real_openat)(int, const char*, int, ...) = NULL;
 static FILE* (*real_fopen)(const char*, const char*) = NULL;
 static int (*real_access)(const char*, int) = NULL;
 static int (*real___open_2)(const char*, int) = NULL;  /* FORTIFY_SOURCE variant */
 
+/* Process creation, for filtering the environment children inherit */
+typedef int (*spawn_fn)(pid_t*, const char*, const posix_spawn_file_actions_t*,
+                        const posix_spawnattr_t*, char* const[], char* const[]);
+static int (*real_execve)(const char*, char* const[], char* const[]) = NULL;
+static int (*real_execvpe)(const char*, char* const[], char* const[]) = NULL;
+static spawn_fn real_posix_spawn = NULL;
+static spawn_fn real_posix_spawnp = NULL;
+
 /* Thread-safe initialization */
 static pthread_once_t init_once = PTHREAD_ONCE_INIT;
 static pthread_mutex_t policy_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -47,9 +78,126 @@ static char* allowed_vars[MAX_ALLOWED_VARS];
 static int allowed_count = 0;
 static int policy_loaded = 0;
 
+/* Compiled policy image mapped from DOTNOPE_POLICY_FILE (read-only, shared) */
+static const void* policy_image = NULL;
+static size_t policy_image_size = 0;
+static int policy_allow_all = 0;
+
+/* Hot-reloadable policy segment mapped from DOTNOPE_POLICY_SHM (see dotnope_policy.h) */
+static const unsigned char* policy_segment = NULL;
+static size_t policy_segment_size = 0;
+static size_t segment_slot_size = 0;
+/* Last checked segment generation: (generation << 2) | checked (2) | valid (1) */
+static uint64_t segment_checked = 0;
+
+/*
+ * Per-thread getenv decision cache. Native callers mostly pass string
+ * literals, so the name pointer repeats; entries are keyed on it, verified
+ * against a copy of the name, and tagged with the policy generation.
+ */
+#define DECISION_CACHE_SIZE 64
+#define DECISION_CACHE_NAME_MAX 42
+
+typedef struct {
+    const char* ptr;
+    dnp_stats_var* stats;   /* counter slot for this name, if stats are on */
+    uint32_t generation;
+    uint8_t len;
+    uint8_t allowed;
+    char name[DECISION_CACHE_NAME_MAX];
+} decision_cache_entry;
+
+static __thread decision_cache_entry decision_cache[DECISION_CACHE_SIZE]
+    __attribute__((tls_model("initial-exec")));
+
+/* Shared-memory counters (DOTNOPE_STATS, see dotnope_stats.h) */
+static dnp_stats_header* stats_region = NULL;
+static char stats_path[320];
+
+/* Filtered copy of environ installed at startup (DOTNOPE_SHADOW_ENVIRON=1) */
+extern char** environ;
+static int shadow_environ_enabled = 0;
+
+/*
+ * Immutable hashed environment snapshot (DOTNOPE_ENV_SNAPSHOT=1).
+ * getenv reads the current snapshot without locks; setenv/unsetenv/putenv/
+ * clearenv serialize on env_write_mutex, update glibc's environ and publish
+ * a new snapshot. Entries point at environ's "NAME=value" strings, which
+ * glibc never frees, so only the tables need reclaiming (epoch-based, see
+ * snapshot_reclaim).
+ */
+typedef struct {
+    uint32_t hash;
+    uint32_t len;           /* name length */
+    const char* str;        /* "NAME=value" */
+} env_snapshot_entry;
+
+typedef struct env_snapshot {
+    char** environ_ptr;     /* environ this was built from */
+    struct env_snapshot* next_retired;
+    uint64_t retired_epoch;
+    uint32_t mask;
+    env_snapshot_entry entries[];
+} env_snapshot;
+
+#define SNAPSHOT_READERS 128
+
+/* One record per reading thread; active holds the epoch a read started in */
+typedef struct {
+    uint64_t active;
+    uint32_t in_use;
+    char pad[64 - sizeof(uint64_t) - sizeof(uint32_t)];
+} env_reader;
+
+static int env_snapshot_enabled = 0;
+
+/* /proc/<pid>/environ protection in the file hooks (DOTNOPE_PROC_PROTECTION=0 turns it off) */
+static int proc_protection_enabled = 1;
+
+/* Move the environment off the kernel's env block at startup (DOTNOPE_SCRUB_ENVIRON=1) */
+#ifdef DOTNOPE_NO_FILE_HOOKS
+static int scrub_environ_enabled = 1;
+#else
+static int scrub_environ_enabled = 0;
+#endif
+
+/* Filter the environment passed to exec and posix_spawn (DOTNOPE_EXEC_FILTER=0 turns it off) */
+static int exec_filter_enabled = 1;
+
+/*
+ * Filtered copy of environ for exec/spawn calls that pass environ itself.
+ * Rebuilt only when environ's pointer array or the policy generation
+ * changed, by posix_spawn and by the pre-fork handler, so the exec in a
+ * forked child finds it ready. A cache is immutable once published;
+ * replaced caches are freed once no exec is using one.
+ */
+typedef struct exec_env_cache {
+    char** source;          /* environ it was built from */
+    size_t count;           /* entries in source */
+    size_t kept;            /* entries in filtered */
+    uint32_t generation;    /* policy generation it was filtered under */
+    struct exec_env_cache* next_retired;
+    char** filtered;        /* NULL-terminated, inside entries */
+    char* entries[];        /* count source pointers, then filtered */
+} exec_env_cache;
+
+static exec_env_cache* exec_cache = NULL;
+static exec_env_cache* exec_cache_retired = NULL;
+static uint32_t exec_cache_users = 0;
+static pthread_mutex_t exec_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static env_snapshot* current_snapshot = NULL;
+static env_snapshot* retired_snapshots = NULL;
+static uint64_t snapshot_epoch = 1;
+static env_reader snapshot_readers[SNAPSHOT_READERS] __attribute__((aligned(64)));
+static __thread env_reader* thread_reader __attribute__((tls_model("initial-exec")));
+static pthread_key_t reader_key;
+static pthread_mutex_t env_write_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /* Logging */
 static int log_enabled = 0;
 static FILE* log_file = NULL;
+static int log_fd = -1;     /* fileno(log_file), for async-signal-safe writes */
 
 /**
  * Log an access attempt
@@ -63,7 +211,298 @@ static void log_access(const char* op, const char* name, int allowed) {
 }
 
 /**
- * Load policy from environment variable or file
+ * Create and map this process's counter region <dir>/dotnope-stats-<pid>.
+ * Called at startup and again in a forked child, which must not keep
+ * counting into its parent's region.
+ *
+ * The directory is usually world-writable /dev/shm, so the file is always
+ * created fresh (O_EXCL) and checked to be ours and private before it is
+ * mapped; a file planted by another user under our name is never reused.
+ */
+static void open_stats_region(const char* dir) {
+    char path[sizeof(stats_path)];
+    snprintf(path, sizeof(path), "%s/dotnope-stats-%d", dir, (int)getpid());
+
+    /* A stale region from an earlier process with this pid; in a sticky
+       directory only our own file can be removed, anything else makes the
+       exclusive create below fail */
+    unlink(path);
+
+    int fd = real_open ? real_open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC | O_NOFOLLOW, 0600) : -1;
+    if (fd < 0) {
+        fprintf(stderr, "[dotnope_preload] Warning: Cannot create stats region %s: %s\n", path, strerror(errno));
+        return;
+    }
+
+    /* The umask may have dropped bits of 0600; the file is ours by now */
+    struct stat st;
+    if (fchmod(fd, 0600) != 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid() ||
+        (st.st_mode & 07777) != 0600) {
+        fprintf(stderr, "[dotnope_preload] Warning: Stats region %s is not a private file of ours\n", path);
+        close(fd);
+        return;
+    }
+
+    size_t size = sizeof(dnp_stats_header) + DNP_STATS_VAR_SLOTS * sizeof(dnp_stats_var);
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        unlink(path);
+        return;
+    }
+
+    void* region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+        unlink(path);
+        return;
+    }
+
+    dnp_stats_header* hdr = (dnp_stats_header*)region;
+    hdr->version = DNP_STATS_VERSION;
+    hdr->pid = (uint32_t)getpid();
+    hdr->var_slots = DNP_STATS_VAR_SLOTS;
+    hdr->name_max = DNP_STATS_NAME_MAX;
+    memcpy(hdr->magic, DNP_STATS_MAGIC, sizeof(hdr->magic));
+
+    memcpy(stats_path, path, sizeof(stats_path));
+    __atomic_store_n(&stats_region, hdr, __ATOMIC_RELEASE);
+}
+
+static void stats_after_fork(void) {
+    char dir[sizeof(stats_path)];
+    memcpy(dir, stats_path, sizeof(dir));
+    char* slash = strrchr(dir, '/');
+    if (!slash) return;
+    *slash = '\0';
+
+    /* Only the forking thread survives; drop its cached counter slots */
+    stats_region = NULL;
+    memset(decision_cache, 0, sizeof(decision_cache));
+    open_stats_region(dir);
+}
+
+/**
+ * Find (or claim) the counter slot for a name. Returns NULL when stats
+ * are off or the probe window is full.
+ */
+static dnp_stats_var* stats_slot(const char* name, size_t len) {
+    dnp_stats_header* region = __atomic_load_n(&stats_region, __ATOMIC_ACQUIRE);
+    if (!region) return NULL;
+
+    dnp_stats_var* vars = (dnp_stats_var*)(region + 1);
+    uint32_t hash = dnp_hash(name, len);
+    size_t stored = len < DNP_STATS_NAME_MAX ? len : DNP_STATS_NAME_MAX - 1;
+
+    for (uint32_t probe = 0; probe < DNP_STATS_MAX_PROBE; probe++) {
+        dnp_stats_var* var = &vars[(hash + probe) & (DNP_STATS_VAR_SLOTS - 1)];
+        uint32_t state = __atomic_load_n(&var->state, __ATOMIC_ACQUIRE);
+
+        if (state == DNP_STATS_SLOT_EMPTY) {
+            if (__atomic_compare_exchange_n(&var->state, &state, DNP_STATS_SLOT_CLAIMED, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                var->hash = hash;
+                memcpy(var->name, name, stored);
+                var->name[stored] = '\0';
+                __atomic_store_n(&var->state, DNP_STATS_SLOT_READY, __ATOMIC_RELEASE);
+                return var;
+            }
+        }
+
+        if (state == DNP_STATS_SLOT_READY && var->hash == hash &&
+            memcmp(var->name, name, stored) == 0 && var->name[stored] == '\0') {
+            return var;
+        }
+    }
+
+    __atomic_fetch_add(&region->dropped, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+/**
+ * Count one decision (relaxed atomics - counters only need to be eventually exact)
+ */
+static void count_access(int op, dnp_stats_var* var, int allowed) {
+    dnp_stats_header* region = __atomic_load_n(&stats_region, __ATOMIC_RELAXED);
+    if (!region) return;
+
+    int idx = allowed ? DNP_STATS_ALLOWED : DNP_STATS_DENIED;
+    __atomic_fetch_add(&region->totals[op][idx], 1, __ATOMIC_RELAXED);
+    if (var) {
+        __atomic_fetch_add(&var->counts[op][idx], 1, __ATOMIC_RELAXED);
+    }
+}
+
+#ifndef DOTNOPE_NO_FILE_HOOKS
+/**
+ * Log and count a blocked open of a protected path
+ */
+static void note_blocked_open(const char* op, const char* path) {
+    log_access(op, path, 0);
+    if (stats_region) {
+        count_access(DNP_OP_OPEN, stats_slot(path, strlen(path)), 0);
+    }
+}
+#endif
+
+/**
+ * Map a compiled policy file (see dotnope_policy.h) read-only.
+ * The image is validated once and then used in place; every process
+ * mapping the same file shares its page-cache pages.
+ * Returns 0 on success, -1 on failure.
+ */
+static int load_policy_file(const char* path) {
+    int fd = real_open ? real_open(path, O_RDONLY | O_CLOEXEC) : -1;
+    if (fd < 0) {
+        fprintf(stderr, "[dotnope_preload] Cannot open policy file %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        fprintf(stderr, "[dotnope_preload] Cannot stat policy file %s\n", path);
+        close(fd);
+        return -1;
+    }
+
+    void* image = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) {
+        fprintf(stderr, "[dotnope_preload] Cannot map policy file %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    const char* problem = dnp_policy_validate(image, (size_t)st.st_size);
+    if (problem) {
+        fprintf(stderr, "[dotnope_preload] Invalid policy file %s: %s\n", path, problem);
+        munmap(image, (size_t)st.st_size);
+        return -1;
+    }
+
+    const dnp_policy_header* hdr = (const dnp_policy_header*)image;
+    policy_image = image;
+    policy_image_size = (size_t)st.st_size;
+    policy_allow_all = (hdr->flags & DNP_POLICY_FLAG_ALLOW_ALL) != 0;
+
+    if (log_enabled) {
+        fprintf(log_file, "[dotnope_preload] Mapped policy file %s with %u allowed vars, %u packages\n",
+                path, hdr->var_count, hdr->package_count);
+        fflush(log_file);
+    }
+
+    return 0;
+}
+
+/**
+ * Map a policy segment (see dotnope_policy.h) read-only and shared, so that
+ * images published by the controller become visible without a restart.
+ * Returns 0 on success, -1 on failure.
+ */
+static int load_policy_segment(const char* path) {
+    int fd = real_open ? real_open(path, O_RDONLY | O_CLOEXEC) : -1;
+    if (fd < 0) {
+        fprintf(stderr, "[dotnope_preload] Cannot open policy segment %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < DNP_SEGMENT_HEADER_SIZE) {
+        fprintf(stderr, "[dotnope_preload] Invalid policy segment %s\n", path);
+        close(fd);
+        return -1;
+    }
+
+    void* segment = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+        fprintf(stderr, "[dotnope_preload] Cannot map policy segment %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    const dnp_segment_header* hdr = (const dnp_segment_header*)segment;
+    size_t slot_size = hdr->slot_size;
+    if (memcmp(hdr->magic, DNP_SEGMENT_MAGIC, DNP_POLICY_MAGIC_LEN) != 0 ||
+        hdr->version != DNP_SEGMENT_VERSION ||
+        slot_size < sizeof(dnp_policy_header) || (slot_size & 7) != 0 ||
+        DNP_SEGMENT_HEADER_SIZE + 2 * slot_size > (size_t)st.st_size) {
+        fprintf(stderr, "[dotnope_preload] Invalid policy segment %s: bad header\n", path);
+        munmap(segment, (size_t)st.st_size);
+        return -1;
+    }
+
+    policy_segment = segment;
+    policy_segment_size = (size_t)st.st_size;
+    segment_slot_size = slot_size;
+
+    if (log_enabled) {
+        fprintf(log_file, "[dotnope_preload] Mapped policy segment %s (generation %u)\n",
+                path, __atomic_load_n(&hdr->generation, __ATOMIC_ACQUIRE));
+        fflush(log_file);
+    }
+
+    return 0;
+}
+
+/**
+ * Check (once per generation) that the image published in a segment slot
+ * is complete and well-formed. Whichever thread first sees a new generation
+ * validates it; an invalid image fails closed until the next publish.
+ */
+static int segment_generation_valid(uint32_t generation, const unsigned char* slot) {
+    uint64_t checked = __atomic_load_n(&segment_checked, __ATOMIC_ACQUIRE);
+    if ((checked & 2) && (uint32_t)(checked >> 2) == generation) {
+        return (int)(checked & 1);
+    }
+
+    uint32_t total_size;
+    memcpy(&total_size, slot + offsetof(dnp_policy_header, total_size), sizeof(total_size));
+    int valid = total_size <= segment_slot_size && dnp_policy_validate(slot, total_size) == NULL;
+
+    /* Same read side as segment_allows(): the slot reads must complete
+       before the generation is re-checked, or a torn image could be
+       recorded as valid for this generation */
+    const dnp_segment_header* hdr = (const dnp_segment_header*)policy_segment;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&hdr->generation, __ATOMIC_RELAXED) == generation) {
+        __atomic_store_n(&segment_checked, ((uint64_t)generation << 2) | 2 | (uint64_t)valid, __ATOMIC_RELEASE);
+        if (log_enabled) {
+            fprintf(log_file, "[dotnope_preload] Policy generation %u %s\n",
+                    generation, valid ? "loaded" : "INVALID (failing closed)");
+            fflush(log_file);
+        }
+    }
+
+    return valid;
+}
+
+/**
+ * Look up a variable in the active segment slot without locking.
+ * The generation is sampled before and after the lookup; if the controller
+ * published in between, the lookup is simply repeated (seqlock).
+ */
+static int segment_allows(const char* name, size_t len) {
+    const dnp_segment_header* hdr = (const dnp_segment_header*)policy_segment;
+
+    for (;;) {
+        uint32_t generation = __atomic_load_n(&hdr->generation, __ATOMIC_ACQUIRE);
+        const unsigned char* slot = policy_segment + DNP_SEGMENT_HEADER_SIZE +
+                                    (size_t)(generation & 1) * segment_slot_size;
+        int allowed = 0;
+
+        if (segment_generation_valid(generation, slot)) {
+            const dnp_policy_header* image = (const dnp_policy_header*)slot;
+            allowed = (image->flags & DNP_POLICY_FLAG_ALLOW_ALL) ||
+                      dnp_policy_contains(slot, segment_slot_size, name, len);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&hdr->generation, __ATOMIC_RELAXED) == generation) {
+            return allowed;
+        }
+    }
+}
+
+/**
+ * Load policy from policy segment, compiled policy file or environment variable
  * Format: comma-separated list of allowed variables, or "*" for all
  */
 static void load_policy(void) {
@@ -83,9 +522,70 @@ static void load_policy(void) {
         if (strcmp(log_env, "1") == 0 || strcmp(log_env, "stderr") == 0) {
             log_file = stderr;
         } else {
-            log_file = fopen(log_env, "a");
+            /* Not the fopen hook: this runs inside pthread_once(init_real_functions) */
+            log_file = real_fopen ? real_fopen(log_env, "a") : NULL;
             if (!log_file) log_file = stderr;
         }
+        log_fd = fileno(log_file);
+    }
+
+    const char* stats_env = real_getenv ? real_getenv("DOTNOPE_STATS") : getenv("DOTNOPE_STATS");
+    if (stats_env && *stats_env && strcmp(stats_env, "0") != 0) {
+        open_stats_region(stats_env[0] == '/' ? stats_env : "/dev/shm");
+        if (stats_region) {
+            pthread_atfork(NULL, NULL, stats_after_fork);
+        }
+    }
+
+    const char* shadow_env = real_getenv ? real_getenv("DOTNOPE_SHADOW_ENVIRON") : getenv("DOTNOPE_SHADOW_ENVIRON");
+    shadow_environ_enabled = shadow_env && strcmp(shadow_env, "1") == 0;
+
+    const char* snapshot_env = real_getenv ? real_getenv("DOTNOPE_ENV_SNAPSHOT") : getenv("DOTNOPE_ENV_SNAPSHOT");
+    env_snapshot_enabled = snapshot_env && strcmp(snapshot_env, "1") == 0;
+
+#ifndef DOTNOPE_NO_FILE_HOOKS
+    const char* scrub_env = real_getenv ? real_getenv("DOTNOPE_SCRUB_ENVIRON") : getenv("DOTNOPE_SCRUB_ENVIRON");
+    scrub_environ_enabled = scrub_env && strcmp(scrub_env, "1") == 0;
+#endif
+
+#ifndef DOTNOPE_BAKED_POLICY
+    /* A baked policy also pins /proc protection: reading /proc/<pid>/environ
+       would widen it */
+    const char* proc_env = real_getenv ? real_getenv("DOTNOPE_PROC_PROTECTION") : getenv("DOTNOPE_PROC_PROTECTION");
+    proc_protection_enabled = !(proc_env && strcmp(proc_env, "0") == 0);
+
+    const char* exec_env = real_getenv ? real_getenv("DOTNOPE_EXEC_FILTER") : getenv("DOTNOPE_EXEC_FILTER");
+    exec_filter_enabled = !(exec_env && strcmp(exec_env, "0") == 0);
+#endif
+
+#ifdef DOTNOPE_BAKED_POLICY
+    /* The policy is compiled in and cannot be widened through the environment */
+    policy_loaded = 1;
+    if (log_enabled) {
+        fprintf(log_file, "[dotnope_preload] Using baked policy with %d allowed vars%s\n",
+                DNP_BAKED_VAR_COUNT, DNP_BAKED_ALLOW_ALL ? " (wildcard)" : "");
+        fflush(log_file);
+    }
+    pthread_mutex_unlock(&policy_mutex);
+    return;
+#endif
+
+    /* A policy segment takes precedence, then a compiled file, then the env string.
+       An unusable segment or file fails closed: nothing beyond essentials is allowed */
+    const char* policy_shm = real_getenv ? real_getenv("DOTNOPE_POLICY_SHM") : getenv("DOTNOPE_POLICY_SHM");
+    if (policy_shm && *policy_shm) {
+        load_policy_segment(policy_shm);
+        policy_loaded = 1;
+        pthread_mutex_unlock(&policy_mutex);
+        return;
+    }
+
+    const char* policy_file = real_getenv ? real_getenv("DOTNOPE_POLICY_FILE") : getenv("DOTNOPE_POLICY_FILE");
+    if (policy_file && *policy_file) {
+        load_policy_file(policy_file);
+        policy_loaded = 1;
+        pthread_mutex_unlock(&policy_mutex);
+        return;
     }
 
     /* Get policy */
@@ -127,26 +627,52 @@ static void load_policy(void) {
     pthread_mutex_unlock(&policy_mutex);
 }
 
+/**
+ * Check if a variable is one every policy allows
+ */
+static int is_essential_len(const char* name, size_t len) {
+#ifdef DOTNOPE_BAKED_POLICY
+    return dnp_baked_essential(name, len);
+#else
+    return (len == 4 && (memcmp(name, "PATH", 4) == 0 ||
+                         memcmp(name, "HOME", 4) == 0 ||
+                         memcmp(name, "USER", 4) == 0 ||
+                         memcmp(name, "TERM", 4) == 0 ||
+                         memcmp(name, "LANG", 4) == 0)) ||
+           (len == 5 && memcmp(name, "SHELL", 5) == 0) ||
+           (len == 6 && memcmp(name, "LC_ALL", 6) == 0) ||
+           (len >= 8 && memcmp(name, "DOTNOPE_", 8) == 0);
+#endif
+}
+
 /**
  * Check if a variable is allowed
+ * @param name  variable name (not necessarily NUL-terminated, e.g. "NAME=value")
+ * @param len   length of the name
  */
-static int is_allowed(const char* name) {
+static int is_allowed_len(const char* name, size_t len) {
     if (!policy_loaded) {
         load_policy();
     }
 
+#ifdef DOTNOPE_BAKED_POLICY
+    return dnp_baked_essential(name, len) || dnp_baked_contains(name, len);
+#endif
+
     /* Always allow some essential variables */
-    if (strcmp(name, "PATH") == 0 ||
-        strcmp(name, "HOME") == 0 ||
-        strcmp(name, "USER") == 0 ||
-        strcmp(name, "SHELL") == 0 ||
-        strcmp(name, "TERM") == 0 ||
-        strcmp(name, "LANG") == 0 ||
-        strcmp(name, "LC_ALL") == 0 ||
-        strncmp(name, "DOTNOPE_", 8) == 0) {
+    if (is_essential_len(name, len)) {
         return 1;
     }
 
+    if (policy_segment) {
+        return segment_allows(name, len);
+    }
+
+    /* Compiled policy is immutable once mapped - no locking needed */
+    if (policy_image) {
+        return policy_allow_all || dnp_policy_contains(policy_image, policy_image_size, name, len);
+    }
+
     pthread_mutex_lock(&policy_mutex);
 
     for (int i = 0; i < allowed_count; i++) {
@@ -154,7 +680,7 @@ static int is_allowed(const char* name) {
             pthread_mutex_unlock(&policy_mutex);
             return 1;
         }
-        if (strcmp(allowed_vars[i], name) == 0) {
+        if (strncmp(allowed_vars[i], name, len) == 0 && allowed_vars[i][len] == '\0') {
             pthread_mutex_unlock(&policy_mutex);
             return 1;
         }
@@ -164,8 +690,67 @@ static int is_allowed(const char* name) {
     return 0;
 }
 
+static int is_allowed(const char* name) {
+    return is_allowed_len(name, strlen(name));
+}
+
+/**
+ * Current policy generation; only a policy segment ever changes it
+ */
+static inline uint32_t policy_generation(void) {
+    if (policy_segment) {
+        return __atomic_load_n(&((const dnp_segment_header*)policy_segment)->generation, __ATOMIC_ACQUIRE);
+    }
+    return 0;
+}
+
+/**
+ * is_allowed() through the thread-local decision cache
+ * @param stats  receives the counter slot for name when stats are enabled
+ */
+static int is_allowed_cached(const char* name, dnp_stats_var** stats) {
+    if (!policy_loaded) {
+        load_policy();
+    }
+
+    uintptr_t key = (uintptr_t)name;
+    decision_cache_entry* entry = &decision_cache[((key >> 3) ^ (key >> 11)) & (DECISION_CACHE_SIZE - 1)];
+    uint32_t generation = policy_generation();
+
+    /* The name behind a pointer can change (stack or heap buffers), so the
+       cached copy is compared too; that is still cheaper than a lookup.
+       The length is checked first so a shorter name is never read past
+       its terminator */
+    if (entry->ptr == name && entry->generation == generation &&
+        strnlen(name, (size_t)entry->len + 1) == entry->len &&
+        memcmp(entry->name, name, entry->len) == 0) {
+        *stats = entry->stats;
+        return entry->allowed;
+    }
+
+    size_t len = strlen(name);
+    int allowed = is_allowed_len(name, len);
+    *stats = stats_region ? stats_slot(name, len) : NULL;
+
+    if (len < DECISION_CACHE_NAME_MAX) {
+        /* Publish the pointer last in case a signal handler calls getenv mid-update */
+        entry->ptr = NULL;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        entry->stats = *stats;
+        entry->generation = generation;
+        entry->len = (uint8_t)len;
+        entry->allowed = (uint8_t)allowed;
+        memcpy(entry->name, name, len);
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        entry->ptr = name;
+    }
+
+    return allowed;
+}
+
+#ifndef DOTNOPE_NO_FILE_HOOKS
 /**
- * Check if a path is protected (e.g., /proc/*/environ)
+ * Check if a path is protected (e.g., /proc/<pid>/environ)
  * This prevents native code from reading environment variables directly from /proc
  */
 static int is_protected_path(const char* path) {
@@ -190,6 +775,196 @@ static int is_protected_path(const char* path) {
 
     return 0;
 }
+#endif
+
+/**
+ * Build a snapshot of the current environ. Called with env_write_mutex
+ * held (or before other threads can write). Returns NULL on allocation
+ * failure; readers then fall back to glibc.
+ */
+static env_snapshot* snapshot_build(void) {
+    char** env = environ;
+    size_t count = 0;
+    while (env && env[count]) count++;
+
+    uint32_t buckets = 16;
+    while (buckets < count * 2) buckets <<= 1;
+
+    env_snapshot* snap = calloc(1, sizeof(env_snapshot) + buckets * sizeof(env_snapshot_entry));
+    if (!snap) return NULL;
+    snap->environ_ptr = env;
+    snap->mask = buckets - 1;
+
+    for (size_t i = 0; i < count; i++) {
+        const char* eq = strchr(env[i], '=');
+        if (!eq) continue;
+
+        uint32_t len = (uint32_t)(eq - env[i]);
+        uint32_t hash = dnp_hash(env[i], len);
+        for (uint32_t slot = hash & snap->mask;; slot = (slot + 1) & snap->mask) {
+            env_snapshot_entry* entry = &snap->entries[slot];
+            if (!entry->str) {
+                *entry = (env_snapshot_entry){ hash, len, env[i] };
+                break;
+            }
+            /* glibc's getenv returns the first duplicate; so do we */
+            if (entry->hash == hash && entry->len == len && memcmp(entry->str, env[i], len) == 0) {
+                break;
+            }
+        }
+    }
+
+    return snap;
+}
+
+/**
+ * Free retired snapshots no reader can still see. A snapshot retired at
+ * epoch E was unpublished before the epoch moved past E, so a reader
+ * whose active epoch is 0 or greater than E cannot hold it.
+ * Called with env_write_mutex held.
+ */
+static void snapshot_reclaim(void) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < SNAPSHOT_READERS; i++) {
+        uint64_t active = __atomic_load_n(&snapshot_readers[i].active, __ATOMIC_SEQ_CST);
+        if (active && active < oldest) oldest = active;
+    }
+
+    env_snapshot** link = &retired_snapshots;
+    while (*link) {
+        env_snapshot* snap = *link;
+        if (snap->retired_epoch < oldest) {
+            *link = snap->next_retired;
+            free(snap);
+        } else {
+            link = &snap->next_retired;
+        }
+    }
+}
+
+/**
+ * Publish a snapshot of the current environ. Called with env_write_mutex held.
+ */
+static void snapshot_publish(void) {
+    env_snapshot* old = __atomic_exchange_n(&current_snapshot, snapshot_build(), __ATOMIC_SEQ_CST);
+    uint64_t epoch = __atomic_fetch_add(&snapshot_epoch, 1, __ATOMIC_SEQ_CST);
+
+    if (old) {
+        old->retired_epoch = epoch;
+        old->next_retired = retired_snapshots;
+        retired_snapshots = old;
+    }
+    snapshot_reclaim();
+}
+
+static void snapshot_release_reader(void* reader) {
+    thread_reader = NULL;
+    __atomic_store_n(&((env_reader*)reader)->in_use, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * This thread's reader record, claimed on first use and released at
+ * thread exit. NULL when every record is taken.
+ */
+static env_reader* snapshot_reader(void) {
+    if (thread_reader) return thread_reader;
+
+    for (int i = 0; i < SNAPSHOT_READERS; i++) {
+        uint32_t expected = 0;
+        if (__atomic_compare_exchange_n(&snapshot_readers[i].in_use, &expected, 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            thread_reader = &snapshot_readers[i];
+            pthread_setspecific(reader_key, thread_reader);
+            return thread_reader;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * getenv served from the current snapshot
+ */
+static char* snapshot_getenv(const char* name) {
+    env_reader* reader = snapshot_reader();
+    if (!reader) {
+        /* Out of reader records: serialize with writers instead */
+        pthread_mutex_lock(&env_write_mutex);
+        char* value = real_getenv(name);
+        pthread_mutex_unlock(&env_write_mutex);
+        return value;
+    }
+
+    /* A signal handler nesting inside a read keeps the outer, older epoch */
+    int outermost = reader->active == 0;
+    if (outermost) {
+        __atomic_store_n(&reader->active, __atomic_load_n(&snapshot_epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+    }
+
+    env_snapshot* snap = __atomic_load_n(&current_snapshot, __ATOMIC_SEQ_CST);
+    char* value = NULL;
+    int fallback = !snap || snap->environ_ptr != environ;
+
+    if (!fallback) {
+        uint32_t hash = DNP_FNV_OFFSET;
+        size_t len = 0;
+        for (const unsigned char* p = (const unsigned char*)name; *p; p++, len++) {
+            hash = (hash ^ *p) * DNP_FNV_PRIME;
+        }
+
+        for (uint32_t slot = hash & snap->mask;; slot = (slot + 1) & snap->mask) {
+            const env_snapshot_entry* entry = &snap->entries[slot];
+            if (!entry->str) break;
+            if (entry->hash == hash && entry->len == len && memcmp(entry->str, name, len) == 0) {
+                value = (char*)entry->str + len + 1;
+                break;
+            }
+        }
+    }
+
+    if (outermost) {
+        __atomic_store_n(&reader->active, 0, __ATOMIC_RELEASE);
+    }
+
+    /* environ was replaced behind our back (direct assignment or a write
+       that bypassed the hooks): answer from glibc */
+    return fallback ? real_getenv(name) : value;
+}
+
+static void snapshot_before_fork(void) {
+    pthread_mutex_lock(&env_write_mutex);
+}
+
+static void snapshot_after_fork_parent(void) {
+    pthread_mutex_unlock(&env_write_mutex);
+}
+
+static void snapshot_after_fork_child(void) {
+    /* Only the forking thread survives; its record is the only live one */
+    for (int i = 0; i < SNAPSHOT_READERS; i++) {
+        if (&snapshot_readers[i] != thread_reader) {
+            snapshot_readers[i].active = 0;
+            snapshot_readers[i].in_use = 0;
+        }
+    }
+    pthread_mutex_unlock(&env_write_mutex);
+}
+
+/**
+ * Enable the snapshot store once the final environ is in place
+ */
+static void snapshot_init(void) {
+    if (pthread_key_create(&reader_key, snapshot_release_reader) != 0) {
+        fprintf(stderr, "[dotnope_preload] Warning: Cannot enable environment snapshot\n");
+        return;
+    }
+    pthread_atfork(snapshot_before_fork, snapshot_after_fork_parent, snapshot_after_fork_child);
+
+    pthread_mutex_lock(&env_write_mutex);
+    snapshot_publish();
+    pthread_mutex_unlock(&env_write_mutex);
+}
+
+static void select_implementations(void);
 
 /**
  * Initialize by loading real libc functions
@@ -198,6 +973,8 @@ static void init_real_functions(void) {
     real_getenv = dlsym(RTLD_NEXT, "getenv");
     real_setenv = dlsym(RTLD_NEXT, "setenv");
     real_unsetenv = dlsym(RTLD_NEXT, "unsetenv");
+    real_putenv = dlsym(RTLD_NEXT, "putenv");
+    real_clearenv = dlsym(RTLD_NEXT, "clearenv");
 
     /* File access functions for /proc protection */
     real_open = dlsym(RTLD_NEXT, "open");
@@ -206,7 +983,12 @@ static void init_real_functions(void) {
     real_access = dlsym(RTLD_NEXT, "access");
     real___open_2 = dlsym(RTLD_NEXT, "__open_2");  /* May be NULL on some systems */
 
-    if (!real_getenv || !real_setenv || !real_unsetenv) {
+    real_execve = dlsym(RTLD_NEXT, "execve");
+    real_execvpe = dlsym(RTLD_NEXT, "execvpe");
+    real_posix_spawn = dlsym(RTLD_NEXT, "posix_spawn");
+    real_posix_spawnp = dlsym(RTLD_NEXT, "posix_spawnp");
+
+    if (!real_getenv || !real_setenv || !real_unsetenv || !real_putenv || !real_clearenv) {
         fprintf(stderr, "[dotnope_preload] Failed to load libc functions\n");
         _exit(1);
     }
@@ -216,32 +998,34 @@ static void init_real_functions(void) {
     }
 
     load_policy();
+    select_implementations();
 }
 
 /**
- * Hooked getenv
+ * getenv with policy enforcement
  */
-char* getenv(const char* name) {
-    pthread_once(&init_once, init_real_functions);
-
+static char* getenv_checked(const char* name) {
     if (!name) return NULL;
 
-    int allowed = is_allowed(name);
+    dnp_stats_var* stats;
+    int allowed = is_allowed_cached(name, &stats);
     log_access("getenv", name, allowed);
+    if (stats_region) count_access(DNP_OP_GETENV, stats, allowed);
 
     if (!allowed) {
         return NULL;
     }
 
+    if (__atomic_load_n(&current_snapshot, __ATOMIC_RELAXED)) {
+        return snapshot_getenv(name);
+    }
     return real_getenv(name);
 }
 
 /**
- * Hooked setenv
+ * setenv with policy enforcement
  */
-int setenv(const char* name, const char* value, int overwrite) {
-    pthread_once(&init_once, init_real_functions);
-
+static int setenv_checked(const char* name, const char* value, int overwrite) {
     if (!name) {
         errno = EINVAL;
         return -1;
@@ -249,21 +1033,28 @@ int setenv(const char* name, const char* value, int overwrite) {
 
     int allowed = is_allowed(name);
     log_access("setenv", name, allowed);
+    if (stats_region) count_access(DNP_OP_SETENV, stats_slot(name, strlen(name)), allowed);
 
     if (!allowed) {
         errno = EPERM;
         return -1;
     }
 
-    return real_setenv(name, value, overwrite);
+    if (!env_snapshot_enabled) {
+        return real_setenv(name, value, overwrite);
+    }
+
+    pthread_mutex_lock(&env_write_mutex);
+    int result = real_setenv(name, value, overwrite);
+    if (result == 0) snapshot_publish();
+    pthread_mutex_unlock(&env_write_mutex);
+    return result;
 }
 
 /**
- * Hooked unsetenv
+ * unsetenv with policy enforcement
  */
-int unsetenv(const char* name) {
-    pthread_once(&init_once, init_real_functions);
-
+static int unsetenv_checked(const char* name) {
     if (!name) {
         errno = EINVAL;
         return -1;
@@ -271,80 +1062,380 @@ int unsetenv(const char* name) {
 
     int allowed = is_allowed(name);
     log_access("unsetenv", name, allowed);
+    if (stats_region) count_access(DNP_OP_UNSETENV, stats_slot(name, strlen(name)), allowed);
 
     if (!allowed) {
         errno = EPERM;
         return -1;
     }
 
-    return real_unsetenv(name);
+    if (!env_snapshot_enabled) {
+        return real_unsetenv(name);
+    }
+
+    pthread_mutex_lock(&env_write_mutex);
+    int result = real_unsetenv(name);
+    if (result == 0) snapshot_publish();
+    pthread_mutex_unlock(&env_write_mutex);
+    return result;
 }
 
 /**
- * Hooked open - block /proc/*/environ access
+ * putenv with the same policy as setenv ("NAME" without '=' unsets)
  */
-int open(const char* pathname, int flags, ...) {
-    pthread_once(&init_once, init_real_functions);
-
-    if (!real_open) {
-        errno = ENOSYS;
+static int putenv_checked(char* string) {
+    if (!string) {
+        errno = EINVAL;
         return -1;
     }
 
-    if (is_protected_path(pathname)) {
-        log_access("open", pathname, 0);
-        errno = EACCES;
+    const char* eq = strchr(string, '=');
+    size_t len = eq ? (size_t)(eq - string) : strlen(string);
+    int allowed = is_allowed_len(string, len);
+    if (log_enabled) {
+        /* Log the name only, never the value */
+        char logged[128];
+        snprintf(logged, sizeof(logged), "%.*s", (int)len, string);
+        log_access("putenv", logged, allowed);
+    }
+    if (stats_region) count_access(eq ? DNP_OP_SETENV : DNP_OP_UNSETENV, stats_slot(string, len), allowed);
+
+    if (!allowed) {
+        errno = EPERM;
         return -1;
     }
 
-    /* Handle variadic mode argument for O_CREAT */
-    if (flags & O_CREAT) {
-        va_list args;
-        va_start(args, flags);
-        mode_t mode = va_arg(args, mode_t);
-        va_end(args);
-        return real_open(pathname, flags, mode);
+    if (!env_snapshot_enabled) {
+        return real_putenv(string);
     }
 
-    return real_open(pathname, flags);
+    pthread_mutex_lock(&env_write_mutex);
+    int result = real_putenv(string);
+    if (result == 0) snapshot_publish();
+    pthread_mutex_unlock(&env_write_mutex);
+    return result;
+}
+
+static size_t env_count(char* const envp[]) {
+    size_t count = 0;
+    while (envp && envp[count]) count++;
+    return count;
 }
 
+/* Returned by exec_env_filter when the kept entries do not fit */
+#define EXEC_ENV_OVERFLOW ((size_t)-1)
+
 /**
- * Hooked open64 - 64-bit variant (often same as open on modern systems)
+ * Copy the allowed entries of envp (only the essentials if essential_only)
+ * into out, which has room for max entries plus the terminating NULL.
+ * LD_PRELOAD is kept so that children stay protected. Returns the number
+ * of entries kept, or EXEC_ENV_OVERFLOW with out holding the first max.
  */
-int open64(const char* pathname, int flags, ...) {
-    pthread_once(&init_once, init_real_functions);
+static size_t exec_env_filter(char* const envp[], char** out, size_t max, int essential_only) {
+    size_t kept = 0;
+    for (size_t i = 0; envp && envp[i]; i++) {
+        const char* eq = strchr(envp[i], '=');
+        if (!eq) continue;
+
+        size_t len = (size_t)(eq - envp[i]);
+        if ((essential_only ? is_essential_len(envp[i], len) : is_allowed_len(envp[i], len)) ||
+            (len == 10 && memcmp(envp[i], "LD_PRELOAD", 10) == 0)) {
+            if (kept == max) {
+                out[kept] = NULL;
+                return EXEC_ENV_OVERFLOW;
+            }
+            out[kept++] = envp[i];
+        }
+    }
+    out[kept] = NULL;
+    return kept;
+}
+
+/**
+ * Whether cache still describes environ: same array, same entry pointers
+ * (setenv/putenv replace pointers, they never edit strings in place) and
+ * the same policy generation. No name is looked up.
+ */
+static int exec_cache_valid(const exec_env_cache* cache) {
+    char** env = environ;
+    if (!cache || cache->source != env || cache->generation != policy_generation()) {
+        return 0;
+    }
+    for (size_t i = 0; i < cache->count; i++) {
+        if (env[i] != cache->entries[i]) return 0;
+    }
+    return cache->count == 0 ? (!env || !env[0]) : env[cache->count] == NULL;
+}
+
+/**
+ * Rebuild the cache if environ changed. Called with exec_cache_mutex held.
+ */
+static void exec_cache_refresh(void) {
+    if (exec_cache_valid(exec_cache)) return;
+
+    char** env = environ;
+    size_t count = env_count(env);
+    exec_env_cache* cache = malloc(sizeof(exec_env_cache) + (2 * count + 1) * sizeof(char*));
+    if (!cache) return;
+
+    cache->source = env;
+    cache->count = count;
+    cache->generation = policy_generation();
+    cache->next_retired = NULL;
+    if (count) memcpy(cache->entries, env, count * sizeof(char*));
+    cache->filtered = cache->entries + count;
+    cache->kept = exec_env_filter(env, cache->filtered, count, 0);
+
+    exec_env_cache* old = __atomic_exchange_n(&exec_cache, cache, __ATOMIC_SEQ_CST);
+    if (old) {
+        old->next_retired = exec_cache_retired;
+        exec_cache_retired = old;
+    }
+
+    /* A user that counted itself before the exchange may hold a retired
+       cache; one counting itself after it can only see the new one */
+    if (__atomic_load_n(&exec_cache_users, __ATOMIC_SEQ_CST) == 0) {
+        while (exec_cache_retired) {
+            exec_env_cache* next = exec_cache_retired->next_retired;
+            free(exec_cache_retired);
+            exec_cache_retired = next;
+        }
+    }
+}
+
+static void exec_env_before_fork(void) {
+    pthread_mutex_lock(&exec_cache_mutex);
+    exec_cache_refresh();
+    /* The child filters without the cache when envp is not environ; make
+       sure no other thread holds the policy lock across the fork */
+    pthread_mutex_lock(&policy_mutex);
+}
+
+static void exec_env_after_fork(void) {
+    pthread_mutex_unlock(&policy_mutex);
+    pthread_mutex_unlock(&exec_cache_mutex);
+}
+
+/* Entries an exec can pass without allocating; see exec_env_prepare() */
+#define EXEC_ENV_STACK_MAX 512
+
+typedef struct {
+    char** envp;                /* filtered environment to pass on */
+    int cached;                 /* envp belongs to exec_cache */
+    char** heap;
+    char* stack[EXEC_ENV_STACK_MAX + 1];
+} exec_env;
+
+/**
+ * Append a string to a log line being built in buf
+ */
+static size_t log_append(char* buf, size_t at, size_t size, const char* text) {
+    while (*text && at < size) buf[at++] = *text++;
+    return at;
+}
+
+/**
+ * Append a decimal number to a log line being built in buf
+ */
+static size_t log_append_size(char* buf, size_t at, size_t size, size_t value) {
+    char digits[24];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n && at < size) buf[at++] = digits[--n];
+    return at;
+}
+
+/**
+ * Log the environment passed by an exec or spawn call. Uses only write(2),
+ * since an exec may run in a forked child where stdio is not safe.
+ */
+static void log_exec_env(const char* op, size_t kept, size_t count, const char* note) {
+    if (!log_enabled || log_fd < 0) return;
+
+    char line[160];
+    size_t at = log_append(line, 0, sizeof(line), "[dotnope_preload] ");
+    at = log_append(line, at, sizeof(line), op);
+    at = log_append(line, at, sizeof(line), ": passing ");
+    at = log_append_size(line, at, sizeof(line), kept);
+    at = log_append(line, at, sizeof(line), " of ");
+    at = log_append_size(line, at, sizeof(line), count);
+    at = log_append(line, at, sizeof(line), " variables");
+    at = log_append(line, at, sizeof(line), note);
+    at = log_append(line, at, sizeof(line), "\n");
+
+    ssize_t ignored = write(log_fd, line, at);
+    (void)ignored;
+}
+
+/**
+ * Prepare the filtered environment for one exec or spawn call.
+ * When envp is environ the cache is used; refresh lets this call rebuild a
+ * stale cache first, which must not happen between fork and exec (the
+ * pre-fork handler has done it) or in a vfork child.
+ *
+ * Only a spawn (refresh set, running in the parent) may allocate. An exec
+ * can run in a forked child, where malloc is not async-signal-safe, so it
+ * filters into the stack buffer; if more than EXEC_ENV_STACK_MAX variables
+ * are allowed it fails closed and passes only the essentials.
+ * Returns 0, or -1 with errno set to ENOMEM.
+ */
+static int exec_env_prepare(exec_env* env, char* const envp[], int refresh, const char* op) {
+    env->cached = 0;
+    env->heap = NULL;
+
+    if (envp == environ) {
+        if (refresh) {
+            pthread_mutex_lock(&exec_cache_mutex);
+            exec_cache_refresh();
+            pthread_mutex_unlock(&exec_cache_mutex);
+        }
+
+        __atomic_fetch_add(&exec_cache_users, 1, __ATOMIC_SEQ_CST);
+        exec_env_cache* cache = __atomic_load_n(&exec_cache, __ATOMIC_SEQ_CST);
+        if (exec_cache_valid(cache)) {
+            env->envp = cache->filtered;
+            env->cached = 1;
+            log_exec_env(op, cache->kept, cache->count, " (cached)");
+            return 0;
+        }
+        __atomic_fetch_sub(&exec_cache_users, 1, __ATOMIC_SEQ_CST);
+    }
+
+    size_t count = env_count(envp);
+    size_t capacity = EXEC_ENV_STACK_MAX;
+    env->envp = env->stack;
+    if (refresh && count > EXEC_ENV_STACK_MAX) {
+        env->heap = malloc((count + 1) * sizeof(char*));
+        if (!env->heap) {
+            errno = ENOMEM;
+            return -1;
+        }
+        env->envp = env->heap;
+        capacity = count;
+    }
+
+    size_t kept = exec_env_filter(envp, env->envp, capacity, 0);
+    if (kept == EXEC_ENV_OVERFLOW) {
+        kept = exec_env_filter(envp, env->envp, capacity, 1);
+        if (kept == EXEC_ENV_OVERFLOW) kept = capacity;
+        log_exec_env(op, kept, count, " (too many allowed; essentials only)");
+        return 0;
+    }
+    log_exec_env(op, kept, count, "");
+    return 0;
+}
+
+/* Runs only if the exec failed or the spawn returned; keeps errno */
+static void exec_env_finish(exec_env* env) {
+    int saved_errno = errno;
+    if (env->cached) {
+        __atomic_fetch_sub(&exec_cache_users, 1, __ATOMIC_SEQ_CST);
+    }
+    free(env->heap);
+    errno = saved_errno;
+}
+
+/**
+ * execve (and execv) with a filtered environment
+ */
+static int execve_checked(const char* path, char* const argv[], char* const envp[]) {
+    if (!real_execve) {
+        errno = ENOSYS;
+        return -1;
+    }
+
+    exec_env env;
+    if (exec_env_prepare(&env, envp, 0, "execve") != 0) return -1;
+    int result = real_execve(path, argv, env.envp);
+    exec_env_finish(&env);
+    return result;
+}
+
+/**
+ * execvpe (and execvp) with a filtered environment
+ */
+static int execvpe_checked(const char* file, char* const argv[], char* const envp[]) {
+    if (!real_execvpe) {
+        errno = ENOSYS;
+        return -1;
+    }
+
+    exec_env env;
+    if (exec_env_prepare(&env, envp, 0, "execvpe") != 0) return -1;
+    int result = real_execvpe(file, argv, env.envp);
+    exec_env_finish(&env);
+    return result;
+}
+
+static int spawn_checked(spawn_fn real, const char* op, pid_t* pid, const char* path,
+                         const posix_spawn_file_actions_t* file_actions,
+                         const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]) {
+    if (!real) return ENOSYS;
+
+    /* posix_spawn runs in the parent, so it may rebuild the cache */
+    exec_env env;
+    if (exec_env_prepare(&env, envp, 1, op) != 0) return ENOMEM;
+    int result = real(pid, path, file_actions, attrp, argv, env.envp);
+    exec_env_finish(&env);
+    return result;
+}
+
+/**
+ * posix_spawn with a filtered environment
+ */
+static int posix_spawn_checked(pid_t* pid, const char* path,
+                               const posix_spawn_file_actions_t* file_actions,
+                               const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]) {
+    return spawn_checked(real_posix_spawn, "posix_spawn", pid, path, file_actions, attrp, argv, envp);
+}
+
+/**
+ * posix_spawnp with a filtered environment
+ */
+static int posix_spawnp_checked(pid_t* pid, const char* file,
+                                const posix_spawn_file_actions_t* file_actions,
+                                const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]) {
+    return spawn_checked(real_posix_spawnp, "posix_spawnp", pid, file, file_actions, attrp, argv, envp);
+}
 
+#ifndef DOTNOPE_NO_FILE_HOOKS
+/* open(2) takes a mode argument only when it may create a file */
+static inline int open_needs_mode(int flags) {
+    return (flags & O_CREAT) || (flags & O_TMPFILE) == O_TMPFILE;
+}
+
+/**
+ * open/open64 with /proc/<pid>/environ protection
+ */
+static int open_checked(const char* pathname, int flags, mode_t mode) {
     if (!real_open) {
         errno = ENOSYS;
         return -1;
     }
 
     if (is_protected_path(pathname)) {
-        log_access("open64", pathname, 0);
+        note_blocked_open("open", pathname);
         errno = EACCES;
         return -1;
     }
 
-    if (flags & O_CREAT) {
-        va_list args;
-        va_start(args, flags);
-        mode_t mode = va_arg(args, mode_t);
-        va_end(args);
-        return real_open(pathname, flags, mode);
-    }
+    return real_open(pathname, flags, mode);
+}
 
-    return real_open(pathname, flags);
+/* real_open is variadic, so it is always called through a prototype that says so */
+static int open_direct(const char* pathname, int flags, mode_t mode) {
+    return real_open(pathname, flags, mode);
 }
 
 /**
- * Hooked __open_2 - FORTIFY_SOURCE variant used by glibc
+ * __open_2 (FORTIFY_SOURCE variant used by glibc) with /proc protection
  */
-int __open_2(const char* pathname, int flags) {
-    pthread_once(&init_once, init_real_functions);
-
+static int open_2_checked(const char* pathname, int flags) {
     if (is_protected_path(pathname)) {
-        log_access("__open_2", pathname, 0);
+        note_blocked_open("__open_2", pathname);
         errno = EACCES;
         return -1;
     }
@@ -361,47 +1452,43 @@ int __open_2(const char* pathname, int flags) {
     return -1;
 }
 
+static int open_2_direct(const char* pathname, int flags) {
+    return real___open_2 ? real___open_2(pathname, flags) : real_open(pathname, flags);
+}
+
 /**
- * Hooked openat - block /proc/*/environ via dirfd-relative paths
+ * openat with protection for dirfd-relative /proc/<pid>/environ paths
  */
-int openat(int dirfd, const char* pathname, int flags, ...) {
-    pthread_once(&init_once, init_real_functions);
-
+static int openat_checked(int dirfd, const char* pathname, int flags, mode_t mode) {
     if (!real_openat) {
         errno = ENOSYS;
         return -1;
     }
 
     if (is_protected_path(pathname)) {
-        log_access("openat", pathname, 0);
+        note_blocked_open("openat", pathname);
         errno = EACCES;
         return -1;
     }
 
-    if (flags & O_CREAT) {
-        va_list args;
-        va_start(args, flags);
-        mode_t mode = va_arg(args, mode_t);
-        va_end(args);
-        return real_openat(dirfd, pathname, flags, mode);
-    }
+    return real_openat(dirfd, pathname, flags, mode);
+}
 
-    return real_openat(dirfd, pathname, flags);
+static int openat_direct(int dirfd, const char* pathname, int flags, mode_t mode) {
+    return real_openat(dirfd, pathname, flags, mode);
 }
 
 /**
- * Hooked fopen - block /proc/*/environ via stdio
+ * fopen/fopen64 with /proc/<pid>/environ protection
  */
-FILE* fopen(const char* pathname, const char* mode) {
-    pthread_once(&init_once, init_real_functions);
-
+static FILE* fopen_checked(const char* pathname, const char* mode) {
     if (!real_fopen) {
         errno = ENOSYS;
         return NULL;
     }
 
     if (is_protected_path(pathname)) {
-        log_access("fopen", pathname, 0);
+        note_blocked_open("fopen", pathname);
         errno = EACCES;
         return NULL;
     }
@@ -410,43 +1497,485 @@ FILE* fopen(const char* pathname, const char* mode) {
 }
 
 /**
- * Hooked fopen64 - 64-bit variant
+ * access with protection against probing /proc/<pid>/environ
  */
-FILE* fopen64(const char* pathname, const char* mode) {
-    pthread_once(&init_once, init_real_functions);
-
-    if (!real_fopen) {
+static int access_checked(const char* pathname, int mode) {
+    if (!real_access) {
         errno = ENOSYS;
-        return NULL;
+        return -1;
     }
 
     if (is_protected_path(pathname)) {
-        log_access("fopen64", pathname, 0);
+        note_blocked_open("access", pathname);
         errno = EACCES;
-        return NULL;
+        return -1;
     }
 
-    return real_fopen(pathname, mode);
+    return real_access(pathname, mode);
+}
+#endif
+
+/*
+ * Exported hooks dispatch through these pointers. Until initialization
+ * they point at bootstrap functions that run init_real_functions first;
+ * select_implementations then binds each one to the cheapest correct
+ * implementation for this process's configuration, so steady-state calls
+ * pay neither pthread_once nor checks for protections that are off.
+ */
+static char* getenv_bootstrap(const char* name);
+static int setenv_bootstrap(const char* name, const char* value, int overwrite);
+static int unsetenv_bootstrap(const char* name);
+static int putenv_bootstrap(char* string);
+
+static char* (*getenv_impl)(const char*) = getenv_bootstrap;
+static int (*setenv_impl)(const char*, const char*, int) = setenv_bootstrap;
+static int (*unsetenv_impl)(const char*) = unsetenv_bootstrap;
+static int (*putenv_impl)(char*) = putenv_bootstrap;
+
+static int execve_bootstrap(const char* path, char* const argv[], char* const envp[]);
+static int execvpe_bootstrap(const char* file, char* const argv[], char* const envp[]);
+static int posix_spawn_bootstrap(pid_t* pid, const char* path,
+                                 const posix_spawn_file_actions_t* file_actions,
+                                 const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]);
+static int posix_spawnp_bootstrap(pid_t* pid, const char* file,
+                                  const posix_spawn_file_actions_t* file_actions,
+                                  const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]);
+
+static int (*execve_impl)(const char*, char* const[], char* const[]) = execve_bootstrap;
+static int (*execvpe_impl)(const char*, char* const[], char* const[]) = execvpe_bootstrap;
+static spawn_fn posix_spawn_impl = posix_spawn_bootstrap;
+static spawn_fn posix_spawnp_impl = posix_spawnp_bootstrap;
+
+#ifndef DOTNOPE_NO_FILE_HOOKS
+static int open_bootstrap(const char* pathname, int flags, mode_t mode);
+static int open_2_bootstrap(const char* pathname, int flags);
+static int openat_bootstrap(int dirfd, const char* pathname, int flags, mode_t mode);
+static FILE* fopen_bootstrap(const char* pathname, const char* mode);
+static int access_bootstrap(const char* pathname, int mode);
+
+static int (*open_impl)(const char*, int, mode_t) = open_bootstrap;
+static int (*open_2_impl)(const char*, int) = open_2_bootstrap;
+static int (*openat_impl)(int, const char*, int, mode_t) = openat_bootstrap;
+static FILE* (*fopen_impl)(const char*, const char*) = fopen_bootstrap;
+static int (*access_impl)(const char*, int) = access_bootstrap;
+#endif
+
+#define DISPATCH(impl) __atomic_load_n(&(impl), __ATOMIC_ACQUIRE)
+
+static char* getenv_bootstrap(const char* name) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(getenv_impl)(name);
+}
+
+static int setenv_bootstrap(const char* name, const char* value, int overwrite) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(setenv_impl)(name, value, overwrite);
+}
+
+static int unsetenv_bootstrap(const char* name) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(unsetenv_impl)(name);
+}
+
+static int putenv_bootstrap(char* string) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(putenv_impl)(string);
+}
+
+static int execve_bootstrap(const char* path, char* const argv[], char* const envp[]) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(execve_impl)(path, argv, envp);
+}
+
+static int execvpe_bootstrap(const char* file, char* const argv[], char* const envp[]) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(execvpe_impl)(file, argv, envp);
+}
+
+static int posix_spawn_bootstrap(pid_t* pid, const char* path,
+                                 const posix_spawn_file_actions_t* file_actions,
+                                 const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(posix_spawn_impl)(pid, path, file_actions, attrp, argv, envp);
+}
+
+static int posix_spawnp_bootstrap(pid_t* pid, const char* file,
+                                  const posix_spawn_file_actions_t* file_actions,
+                                  const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(posix_spawnp_impl)(pid, file, file_actions, attrp, argv, envp);
 }
 
+#ifndef DOTNOPE_NO_FILE_HOOKS
+static int open_bootstrap(const char* pathname, int flags, mode_t mode) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(open_impl)(pathname, flags, mode);
+}
+
+static int open_2_bootstrap(const char* pathname, int flags) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(open_2_impl)(pathname, flags);
+}
+
+static int openat_bootstrap(int dirfd, const char* pathname, int flags, mode_t mode) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(openat_impl)(dirfd, pathname, flags, mode);
+}
+
+static FILE* fopen_bootstrap(const char* pathname, const char* mode) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(fopen_impl)(pathname, mode);
+}
+
+static int access_bootstrap(const char* pathname, int mode) {
+    pthread_once(&init_once, init_real_functions);
+    return DISPATCH(access_impl)(pathname, mode);
+}
+#endif
+
 /**
- * Hooked access - block checking if /proc/*/environ exists
+ * Whether the loaded policy allows every variable and can never change
  */
-int access(const char* pathname, int mode) {
+static int policy_is_static_allow_all(void) {
+#ifdef DOTNOPE_BAKED_POLICY
+    return DNP_BAKED_ALLOW_ALL;
+#else
+    if (policy_segment) return 0;   /* may be reloaded */
+    if (policy_image) return policy_allow_all;
+    for (int i = 0; i < allowed_count; i++) {
+        if (strcmp(allowed_vars[i], "*") == 0) return 1;
+    }
+    return 0;
+#endif
+}
+
+/**
+ * Bind each hook to its implementation. Called once, at the end of
+ * init_real_functions, when the policy and every switch are known.
+ */
+static void select_implementations(void) {
+    /* With a static '*' policy and nothing observing calls, the env hooks
+       have nothing to do */
+    int env_passthrough = policy_is_static_allow_all() && !log_enabled &&
+                          !stats_region && !env_snapshot_enabled;
+    /* A static '*' policy keeps every variable, so there is nothing to filter */
+    int exec_passthrough = !exec_filter_enabled || policy_is_static_allow_all();
+#ifndef DOTNOPE_NO_FILE_HOOKS
+    int file_passthrough = !proc_protection_enabled && real_open && real_openat &&
+                           real_fopen && real_access;
+#endif
+
+    __atomic_store_n(&getenv_impl, env_passthrough ? real_getenv : getenv_checked, __ATOMIC_RELEASE);
+    __atomic_store_n(&setenv_impl, env_passthrough ? real_setenv : setenv_checked, __ATOMIC_RELEASE);
+    __atomic_store_n(&unsetenv_impl, env_passthrough ? real_unsetenv : unsetenv_checked, __ATOMIC_RELEASE);
+    __atomic_store_n(&putenv_impl, env_passthrough ? real_putenv : putenv_checked, __ATOMIC_RELEASE);
+
+    exec_passthrough = exec_passthrough && real_execve && real_execvpe && real_posix_spawn && real_posix_spawnp;
+    if (!exec_passthrough) {
+        pthread_atfork(exec_env_before_fork, exec_env_after_fork, exec_env_after_fork);
+    }
+    __atomic_store_n(&execve_impl, exec_passthrough ? real_execve : execve_checked, __ATOMIC_RELEASE);
+    __atomic_store_n(&execvpe_impl, exec_passthrough ? real_execvpe : execvpe_checked, __ATOMIC_RELEASE);
+    __atomic_store_n(&posix_spawn_impl, exec_passthrough ? real_posix_spawn : posix_spawn_checked, __ATOMIC_RELEASE);
+    __atomic_store_n(&posix_spawnp_impl, exec_passthrough ? real_posix_spawnp : posix_spawnp_checked, __ATOMIC_RELEASE);
+
+#ifndef DOTNOPE_NO_FILE_HOOKS
+    __atomic_store_n(&open_impl, file_passthrough ? open_direct : open_checked, __ATOMIC_RELEASE);
+    __atomic_store_n(&open_2_impl, file_passthrough ? open_2_direct : open_2_checked, __ATOMIC_RELEASE);
+    __atomic_store_n(&openat_impl, file_passthrough ? openat_direct : openat_checked, __ATOMIC_RELEASE);
+    __atomic_store_n(&fopen_impl, file_passthrough ? real_fopen : fopen_checked, __ATOMIC_RELEASE);
+    __atomic_store_n(&access_impl, file_passthrough ? real_access : access_checked, __ATOMIC_RELEASE);
+    const char* file_hooks = file_passthrough ? "pass-through" : "checked";
+#else
+    const char* file_hooks = "not built";
+#endif
+
+    if (log_enabled) {
+        fprintf(log_file, "[dotnope_preload] env hooks: %s, exec hooks: %s, file hooks: %s\n",
+                env_passthrough ? "pass-through" : "checked",
+                exec_passthrough ? "pass-through" : "filtered", file_hooks);
+        fflush(log_file);
+    }
+}
+
+/**
+ * Hooked getenv
+ */
+char* getenv(const char* name) {
+    return DISPATCH(getenv_impl)(name);
+}
+
+/**
+ * Hooked setenv
+ */
+int setenv(const char* name, const char* value, int overwrite) {
+    return DISPATCH(setenv_impl)(name, value, overwrite);
+}
+
+/**
+ * Hooked unsetenv
+ */
+int unsetenv(const char* name) {
+    return DISPATCH(unsetenv_impl)(name);
+}
+
+/**
+ * Hooked putenv
+ */
+int putenv(char* string) {
+    return DISPATCH(putenv_impl)(string);
+}
+
+/**
+ * Hooked clearenv - only intercepted to keep the snapshot in sync
+ */
+int clearenv(void) {
     pthread_once(&init_once, init_real_functions);
 
-    if (!real_access) {
-        errno = ENOSYS;
-        return -1;
+    if (!env_snapshot_enabled) {
+        return real_clearenv();
     }
 
-    if (is_protected_path(pathname)) {
-        log_access("access", pathname, 0);
-        errno = EACCES;
-        return -1;
+    pthread_mutex_lock(&env_write_mutex);
+    int result = real_clearenv();
+    snapshot_publish();
+    pthread_mutex_unlock(&env_write_mutex);
+    return result;
+}
+
+/**
+ * Hooked execve - filter the child's environment
+ */
+int execve(const char* path, char* const argv[], char* const envp[]) {
+    return DISPATCH(execve_impl)(path, argv, envp);
+}
+
+/**
+ * Hooked execv - glibc's calls execve internally, past the hook
+ */
+int execv(const char* path, char* const argv[]) {
+    return DISPATCH(execve_impl)(path, argv, environ);
+}
+
+/**
+ * Hooked execvpe - filter the child's environment
+ */
+int execvpe(const char* file, char* const argv[], char* const envp[]) {
+    return DISPATCH(execvpe_impl)(file, argv, envp);
+}
+
+/**
+ * Hooked execvp - glibc's calls execvpe internally, past the hook
+ */
+int execvp(const char* file, char* const argv[]) {
+    return DISPATCH(execvpe_impl)(file, argv, environ);
+}
+
+/**
+ * Hooked posix_spawn - filter the child's environment
+ */
+int posix_spawn(pid_t* pid, const char* path, const posix_spawn_file_actions_t* file_actions,
+                const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]) {
+    return DISPATCH(posix_spawn_impl)(pid, path, file_actions, attrp, argv, envp);
+}
+
+/**
+ * Hooked posix_spawnp - filter the child's environment
+ */
+int posix_spawnp(pid_t* pid, const char* file, const posix_spawn_file_actions_t* file_actions,
+                 const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]) {
+    return DISPATCH(posix_spawnp_impl)(pid, file, file_actions, attrp, argv, envp);
+}
+
+#ifndef DOTNOPE_NO_FILE_HOOKS
+/**
+ * Hooked open - block /proc/<pid>/environ access
+ */
+int open(const char* pathname, int flags, ...) {
+    mode_t mode = 0;
+    if (open_needs_mode(flags)) {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
     }
+    return DISPATCH(open_impl)(pathname, flags, mode);
+}
 
-    return real_access(pathname, mode);
+/**
+ * Hooked open64 - 64-bit variant (often same as open on modern systems)
+ */
+int open64(const char* pathname, int flags, ...) {
+    mode_t mode = 0;
+    if (open_needs_mode(flags)) {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+    return DISPATCH(open_impl)(pathname, flags, mode);
+}
+
+/**
+ * Hooked __open_2 - FORTIFY_SOURCE variant used by glibc
+ */
+int __open_2(const char* pathname, int flags) {
+    return DISPATCH(open_2_impl)(pathname, flags);
+}
+
+/**
+ * Hooked openat - block /proc/<pid>/environ via dirfd-relative paths
+ */
+int openat(int dirfd, const char* pathname, int flags, ...) {
+    mode_t mode = 0;
+    if (open_needs_mode(flags)) {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+    return DISPATCH(openat_impl)(dirfd, pathname, flags, mode);
+}
+
+/**
+ * Hooked fopen - block /proc/<pid>/environ via stdio
+ */
+FILE* fopen(const char* pathname, const char* mode) {
+    return DISPATCH(fopen_impl)(pathname, mode);
+}
+
+/**
+ * Hooked fopen64 - 64-bit variant
+ */
+FILE* fopen64(const char* pathname, const char* mode) {
+    return DISPATCH(fopen_impl)(pathname, mode);
+}
+
+/**
+ * Hooked access - block checking if /proc/<pid>/environ exists
+ */
+int access(const char* pathname, int mode) {
+    return DISPATCH(access_impl)(pathname, mode);
+}
+#endif
+
+/**
+ * Replace environ with a filtered copy that only references allowed
+ * variables. Denied variables become invisible to code that iterates
+ * environ, and glibc's getenv scans a shorter array. The strings themselves
+ * are shared with the original block; only the pointer array is new.
+ * LD_PRELOAD is kept so that child processes stay protected.
+ *
+ * This is a startup snapshot: variables denied here stay hidden even if a
+ * later policy reload would allow them.
+ */
+static void install_shadow_environ(void) {
+    char** original = environ;
+    if (!original) return;
+
+    size_t total = 0;
+    while (original[total]) total++;
+
+    char** shadow = malloc((total + 1) * sizeof(char*));
+    if (!shadow) {
+        fprintf(stderr, "[dotnope_preload] Warning: Cannot allocate shadow environ\n");
+        return;
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < total; i++) {
+        const char* eq = strchr(original[i], '=');
+        size_t len = eq ? (size_t)(eq - original[i]) : strlen(original[i]);
+
+        if (is_allowed_len(original[i], len) ||
+            (len == 10 && memcmp(original[i], "LD_PRELOAD", 10) == 0)) {
+            shadow[kept++] = original[i];
+        }
+    }
+    shadow[kept] = NULL;
+
+    environ = shadow;
+
+    if (log_enabled) {
+        fprintf(log_file, "[dotnope_preload] Shadow environ installed: %zu of %zu variables visible\n",
+                kept, total);
+        fflush(log_file);
+    }
+}
+
+/**
+ * Read env_start and env_end (fields 50 and 51 of /proc/self/stat): the
+ * range the kernel serves as /proc/<pid>/environ
+ */
+static int read_env_block(uintptr_t* start, uintptr_t* end) {
+    char buf[2048];
+    int fd = real_open ? real_open("/proc/self/stat", O_RDONLY | O_CLOEXEC) : -1;
+    if (fd < 0) return -1;
+
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+
+    /* comm (field 2) may contain spaces and parentheses; resume after the last ')' */
+    char* fields = strrchr(buf, ')');
+    if (!fields) return -1;
+
+    char* save = NULL;
+    int field = 2;
+    for (char* tok = strtok_r(fields + 1, " ", &save); tok; tok = strtok_r(NULL, " ", &save)) {
+        field++;
+        if (field == 50) *start = (uintptr_t)strtoull(tok, NULL, 10);
+        if (field == 51) {
+            *end = (uintptr_t)strtoull(tok, NULL, 10);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Copy the environment strings out of the kernel's env block into private
+ * memory, repoint environ at the copy and zero the block, so that
+ * /proc/<pid>/environ (the block, as far as the kernel is concerned) no
+ * longer shows any values. Where the process may (CAP_SYS_RESOURCE), the
+ * block is also shrunk to nothing with PR_SET_MM_ENV_END.
+ *
+ * Pointers into the block that other code saved before this constructor ran
+ * would now see empty strings; in practice preload constructors run before
+ * the program reads its environment.
+ */
+static void scrub_environ_block(void) {
+    uintptr_t start = 0, end = 0;
+    if (read_env_block(&start, &end) != 0 || end <= start) {
+        fprintf(stderr, "[dotnope_preload] Warning: Cannot locate environment block; not scrubbed\n");
+        return;
+    }
+
+    size_t size = end - start;
+    char* copy = malloc(size);
+    if (!copy) {
+        fprintf(stderr, "[dotnope_preload] Warning: Cannot allocate environment copy; not scrubbed\n");
+        return;
+    }
+    memcpy(copy, (const void*)start, size);
+
+    /* Works for the original array and for a shadow environ alike */
+    for (char** entry = environ; entry && *entry; entry++) {
+        uintptr_t p = (uintptr_t)*entry;
+        if (p >= start && p < end) {
+            *entry = copy + (p - start);
+        }
+    }
+
+    memset((void*)start, 0, size);
+    int shrunk = prctl(PR_SET_MM, PR_SET_MM_ENV_END, start, 0, 0) == 0;
+
+    if (log_enabled) {
+        fprintf(log_file, "[dotnope_preload] Scrubbed %zu-byte environment block%s\n",
+                size, shrunk ? " (and emptied it)" : "");
+        fflush(log_file);
+    }
 }
 
 /**
@@ -455,6 +1984,18 @@ int access(const char* pathname, int mode) {
 __attribute__((constructor))
 static void dotnope_preload_init(void) {
     pthread_once(&init_once, init_real_functions);
+
+    if (shadow_environ_enabled) {
+        install_shadow_environ();
+    }
+
+    if (scrub_environ_enabled) {
+        scrub_environ_block();
+    }
+
+    if (env_snapshot_enabled) {
+        snapshot_init();
+    }
 }
 
 /**
@@ -470,6 +2011,13 @@ static void dotnope_preload_cleanup(void) {
     }
     allowed_count = 0;
 
+    if (stats_region && stats_region->pid == (uint32_t)getpid()) {
+        unlink(stats_path);
+    }
+
+    /* Mapped policy images are left to process teardown: other threads may
+       still be inside a lookup while destructors run */
+
     if (log_file && log_file != stderr) {
         fclose(log_file);
     }
@@ -0,0 +1,67 @@
+/**
+ * dotnope_stats.h - Shared-memory access counters for libdotnope_preload.so
+ *
+ * With DOTNOPE_STATS set, each preloaded process creates
+ * <dir>/dotnope-stats-<pid> (default dir /dev/shm), maps it shared and
+ * counts every decision with relaxed atomics. External readers
+ * (dotnope-run --stats <pid>) map or read the same file while the process
+ * keeps running. All integers are little-endian.
+ *
+ * Layout:
+ *   dnp_stats_header
+ *   dnp_stats_var[var_slots]   (open-addressed by FNV-1a of the name)
+ *
+ * A variable slot is claimed by CAS on state (EMPTY -> CLAIMED), its name
+ * and hash are written, then state is released as READY. Readers skip
+ * slots that are not READY. Under contention the same name can end up in
+ * two slots; readers sum them. Blocked open() calls are counted under the
+ * path that was requested.
+ */
+
+#ifndef DOTNOPE_STATS_H
+#define DOTNOPE_STATS_H
+
+#include <stdint.h>
+
+#define DNP_STATS_MAGIC "DNPSTATS"
+#define DNP_STATS_VERSION 1
+#define DNP_STATS_VAR_SLOTS 1024
+#define DNP_STATS_NAME_MAX 64
+#define DNP_STATS_MAX_PROBE 32
+
+#define DNP_STATS_SLOT_EMPTY 0u
+#define DNP_STATS_SLOT_CLAIMED 1u
+#define DNP_STATS_SLOT_READY 2u
+
+/* Operations, in counter order */
+enum {
+    DNP_OP_GETENV = 0,
+    DNP_OP_SETENV,
+    DNP_OP_UNSETENV,
+    DNP_OP_OPEN,
+    DNP_OP_COUNT
+};
+
+/* Second counter index */
+#define DNP_STATS_DENIED 0
+#define DNP_STATS_ALLOWED 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t pid;
+    uint32_t var_slots;
+    uint32_t name_max;
+    uint64_t dropped;                           /* events whose name found no slot */
+    uint64_t totals[DNP_OP_COUNT][2];
+    uint64_t reserved[4];
+} dnp_stats_header;                             /* 128 bytes */
+
+typedef struct {
+    uint32_t state;
+    uint32_t hash;
+    char name[DNP_STATS_NAME_MAX];              /* NUL-terminated, truncated */
+    uint64_t counts[DNP_OP_COUNT][2];
+} dnp_stats_var;                                /* 136 bytes */
+
+#endif /* DOTNOPE_STATS_H */
@@ -11,6 +11,7 @@
 #include "stack_trace.h"
 #include "promise_hooks.h"
 #include "isolate_manager.h"
+#include "got_patcher.h"
 
 namespace dotnope {
 
@@ -98,6 +99,11 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     // Isolate management
     exports.Set("getIsolateCount", Napi::Function::New(env, IsolateManager::GetIsolateCount));
 
+    // GOT patching of third-party native addons
+    exports.Set("patchNativeModule", Napi::Function::New(env, GotPatcher::PatchModule));
+    exports.Set("unpatchNativeModules", Napi::Function::New(env, GotPatcher::UnpatchModules));
+    exports.Set("getNativePatchStats", Napi::Function::New(env, GotPatcher::GetStats));
+
     return exports;
 }
 
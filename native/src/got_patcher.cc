@@ -0,0 +1,655 @@
+/**
+ * got_patcher.cc - In-process GOT/PLT patching implementation
+ *
+ * For each patched object the dynamic section is walked for JUMP_SLOT
+ * (PLT) and GLOB_DAT (-fno-plt, address-taken) relocations against the
+ * hooked symbols, and those GOT entries are pointed at the hooks below.
+ * Entries inside PT_GNU_RELRO (full RELRO / BIND_NOW objects) are made
+ * writable only for the store.
+ *
+ * Hooks attribute a call by its return address: the patched object whose
+ * loaded segments contain it supplies the policy. A call that cannot be
+ * attributed (a tail call out of the addon returns into its caller, or a
+ * hooked pointer handed to other code) must still have come through some
+ * patched GOT, so it gets the intersection of all patched policies.
+ *
+ * Not covered: the object is dlopen()ed before it is patched, so its static
+ * constructors (DT_INIT, DT_INIT_ARRAY) call libc unpatched, and shared
+ * libraries it depends on keep their own, unpatched GOTs.
+ */
+
+#include "got_patcher.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define DOTNOPE_GOT_PATCHING 1
+#include <climits>
+#include <dlfcn.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <link.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace dotnope {
+namespace GotPatcher {
+
+bool VarSet::Contains(std::string_view name) const {
+    return all || names.find(name) != names.end();
+}
+
+#ifdef DOTNOPE_GOT_PATCHING
+
+namespace {
+
+#if defined(__LP64__)
+#define DOTNOPE_R_TYPE ELF64_R_TYPE
+#define DOTNOPE_R_SYM ELF64_R_SYM
+#else
+#define DOTNOPE_R_TYPE ELF32_R_TYPE
+#define DOTNOPE_R_SYM ELF32_R_SYM
+#endif
+
+#if defined(__x86_64__)
+constexpr uint32_t kJumpSlot = R_X86_64_JUMP_SLOT;
+constexpr uint32_t kGlobDat = R_X86_64_GLOB_DAT;
+#else
+constexpr uint32_t kJumpSlot = R_AARCH64_JUMP_SLOT;
+constexpr uint32_t kGlobDat = R_AARCH64_GLOB_DAT;
+#endif
+
+struct PatchedSlot {
+    uintptr_t* slot;
+    uintptr_t original;
+    bool relro;
+};
+
+struct PatchedObject {
+    std::string path;
+    std::vector<std::pair<uintptr_t, uintptr_t>> ranges;  // loaded segments
+    std::vector<PatchedSlot> slots;
+    ObjectPolicy policy;
+    std::atomic<uint64_t> allowed{0};
+    std::atomic<uint64_t> denied{0};
+};
+
+// Objects are never removed: Node never unloads addons and hooks may be mid-call
+std::shared_mutex g_mutex;
+std::vector<std::unique_ptr<PatchedObject>> g_objects;
+std::atomic<uint64_t> g_unattributedAllowed{0};
+std::atomic<uint64_t> g_unattributedDenied{0};
+
+struct RealFunctions {
+    char* (*getenv)(const char*);
+    char* (*secure_getenv)(const char*);
+    int (*setenv)(const char*, const char*, int);
+    int (*unsetenv)(const char*);
+    int (*putenv)(char*);
+    int (*open)(const char*, int, ...);
+    int (*open64)(const char*, int, ...);
+    int (*openat)(int, const char*, int, ...);
+    int (*openat64)(int, const char*, int, ...);
+    int (*open_2)(const char*, int);
+    int (*open64_2)(const char*, int);
+    FILE* (*fopen)(const char*, const char*);
+    FILE* (*fopen64)(const char*, const char*);
+};
+
+RealFunctions g_real;
+std::once_flag g_realOnce;
+
+template <typename T>
+void Resolve(T& target, const char* name) {
+    // RTLD_DEFAULT rather than RTLD_NEXT: if libdotnope_preload.so is
+    // loaded too, its hooks stay in the chain
+    target = reinterpret_cast<T>(dlsym(RTLD_DEFAULT, name));
+}
+
+void ResolveRealFunctions() {
+    Resolve(g_real.getenv, "getenv");
+    Resolve(g_real.secure_getenv, "secure_getenv");
+    Resolve(g_real.setenv, "setenv");
+    Resolve(g_real.unsetenv, "unsetenv");
+    Resolve(g_real.putenv, "putenv");
+    Resolve(g_real.open, "open");
+    Resolve(g_real.open64, "open64");
+    Resolve(g_real.openat, "openat");
+    Resolve(g_real.openat64, "openat64");
+    Resolve(g_real.open_2, "__open_2");
+    Resolve(g_real.open64_2, "__open64_2");
+    Resolve(g_real.fopen, "fopen");
+    Resolve(g_real.fopen64, "fopen64");
+}
+
+/**
+ * Patched object whose segments contain addr. Caller holds g_mutex.
+ */
+PatchedObject* FindCaller(const void* addr) {
+    uintptr_t pc = reinterpret_cast<uintptr_t>(addr);
+    for (auto& object : g_objects) {
+        for (const auto& range : object->ranges) {
+            if (pc >= range.first && pc < range.second) {
+                return object.get();
+            }
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Decide an env operation for a call returning to caller
+ */
+bool EnvAllowed(const void* caller, VarSet ObjectPolicy::*set, std::string_view name) {
+    std::shared_lock<std::shared_mutex> lock(g_mutex);
+
+    if (PatchedObject* object = FindCaller(caller)) {
+        bool allowed = (object->policy.*set).Contains(name);
+        (allowed ? object->allowed : object->denied).fetch_add(1, std::memory_order_relaxed);
+        return allowed;
+    }
+
+    bool allowed = true;
+    for (const auto& object : g_objects) {
+        if (!object->slots.empty() && !(object->policy.*set).Contains(name)) {
+            allowed = false;
+            break;
+        }
+    }
+    (allowed ? g_unattributedAllowed : g_unattributedDenied).fetch_add(1, std::memory_order_relaxed);
+    return allowed;
+}
+
+/**
+ * Whether an open of path by caller must be refused (/proc/<pid>/environ)
+ */
+bool OpenBlocked(const void* caller, const char* path) {
+    if (!path || !strstr(path, "/proc/") || !strstr(path, "environ")) {
+        return false;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(g_mutex);
+
+    if (PatchedObject* object = FindCaller(caller)) {
+        if (!object->policy.protectProc) return false;
+        object->denied.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    for (const auto& object : g_objects) {
+        if (!object->slots.empty() && object->policy.protectProc) {
+            g_unattributedDenied.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool OpenNeedsMode(int flags) {
+    return (flags & O_CREAT) || (flags & O_TMPFILE) == O_TMPFILE;
+}
+
+#define DOTNOPE_CALLER __builtin_return_address(0)
+
+__attribute__((noinline)) char* HookGetenv(const char* name) {
+    if (name && !EnvAllowed(DOTNOPE_CALLER, &ObjectPolicy::read, name)) return nullptr;
+    return g_real.getenv(name);
+}
+
+__attribute__((noinline)) char* HookSecureGetenv(const char* name) {
+    if (name && !EnvAllowed(DOTNOPE_CALLER, &ObjectPolicy::read, name)) return nullptr;
+    return g_real.secure_getenv(name);
+}
+
+__attribute__((noinline)) int HookSetenv(const char* name, const char* value, int overwrite) {
+    if (name && !EnvAllowed(DOTNOPE_CALLER, &ObjectPolicy::write, name)) {
+        errno = EPERM;
+        return -1;
+    }
+    return g_real.setenv(name, value, overwrite);
+}
+
+__attribute__((noinline)) int HookUnsetenv(const char* name) {
+    if (name && !EnvAllowed(DOTNOPE_CALLER, &ObjectPolicy::remove, name)) {
+        errno = EPERM;
+        return -1;
+    }
+    return g_real.unsetenv(name);
+}
+
+__attribute__((noinline)) int HookPutenv(char* string) {
+    if (string) {
+        const char* eq = strchr(string, '=');
+        std::string_view name(string, eq ? static_cast<size_t>(eq - string) : strlen(string));
+        // "NAME" without '=' removes the variable
+        if (!EnvAllowed(DOTNOPE_CALLER, eq ? &ObjectPolicy::write : &ObjectPolicy::remove, name)) {
+            errno = EPERM;
+            return -1;
+        }
+    }
+    return g_real.putenv(string);
+}
+
+__attribute__((noinline)) int HookOpen(const char* path, int flags, ...) {
+    mode_t mode = 0;
+    if (OpenNeedsMode(flags)) {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+    if (OpenBlocked(DOTNOPE_CALLER, path)) {
+        errno = EACCES;
+        return -1;
+    }
+    return g_real.open(path, flags, mode);
+}
+
+__attribute__((noinline)) int HookOpen64(const char* path, int flags, ...) {
+    mode_t mode = 0;
+    if (OpenNeedsMode(flags)) {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+    if (OpenBlocked(DOTNOPE_CALLER, path)) {
+        errno = EACCES;
+        return -1;
+    }
+    return g_real.open64(path, flags, mode);
+}
+
+__attribute__((noinline)) int HookOpenat(int dirfd, const char* path, int flags, ...) {
+    mode_t mode = 0;
+    if (OpenNeedsMode(flags)) {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+    if (OpenBlocked(DOTNOPE_CALLER, path)) {
+        errno = EACCES;
+        return -1;
+    }
+    return g_real.openat(dirfd, path, flags, mode);
+}
+
+__attribute__((noinline)) int HookOpenat64(int dirfd, const char* path, int flags, ...) {
+    mode_t mode = 0;
+    if (OpenNeedsMode(flags)) {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+    if (OpenBlocked(DOTNOPE_CALLER, path)) {
+        errno = EACCES;
+        return -1;
+    }
+    return g_real.openat64(dirfd, path, flags, mode);
+}
+
+__attribute__((noinline)) int HookOpen2(const char* path, int flags) {
+    if (OpenBlocked(DOTNOPE_CALLER, path)) {
+        errno = EACCES;
+        return -1;
+    }
+    return g_real.open_2(path, flags);
+}
+
+__attribute__((noinline)) int HookOpen64_2(const char* path, int flags) {
+    if (OpenBlocked(DOTNOPE_CALLER, path)) {
+        errno = EACCES;
+        return -1;
+    }
+    return g_real.open64_2(path, flags);
+}
+
+__attribute__((noinline)) FILE* HookFopen(const char* path, const char* mode) {
+    if (OpenBlocked(DOTNOPE_CALLER, path)) {
+        errno = EACCES;
+        return nullptr;
+    }
+    return g_real.fopen(path, mode);
+}
+
+__attribute__((noinline)) FILE* HookFopen64(const char* path, const char* mode) {
+    if (OpenBlocked(DOTNOPE_CALLER, path)) {
+        errno = EACCES;
+        return nullptr;
+    }
+    return g_real.fopen64(path, mode);
+}
+
+#undef DOTNOPE_CALLER
+
+/**
+ * Hook for an imported symbol name, or 0 if it is not hooked (or libc
+ * does not provide it)
+ */
+uintptr_t HookFor(const char* name) {
+    struct HookEntry {
+        const char* name;
+        const void* real;
+        uintptr_t hook;
+    };
+    const HookEntry hooks[] = {
+        {"getenv", reinterpret_cast<const void*>(g_real.getenv), reinterpret_cast<uintptr_t>(HookGetenv)},
+        {"secure_getenv", reinterpret_cast<const void*>(g_real.secure_getenv), reinterpret_cast<uintptr_t>(HookSecureGetenv)},
+        {"setenv", reinterpret_cast<const void*>(g_real.setenv), reinterpret_cast<uintptr_t>(HookSetenv)},
+        {"unsetenv", reinterpret_cast<const void*>(g_real.unsetenv), reinterpret_cast<uintptr_t>(HookUnsetenv)},
+        {"putenv", reinterpret_cast<const void*>(g_real.putenv), reinterpret_cast<uintptr_t>(HookPutenv)},
+        {"open", reinterpret_cast<const void*>(g_real.open), reinterpret_cast<uintptr_t>(HookOpen)},
+        {"open64", reinterpret_cast<const void*>(g_real.open64), reinterpret_cast<uintptr_t>(HookOpen64)},
+        {"openat", reinterpret_cast<const void*>(g_real.openat), reinterpret_cast<uintptr_t>(HookOpenat)},
+        {"openat64", reinterpret_cast<const void*>(g_real.openat64), reinterpret_cast<uintptr_t>(HookOpenat64)},
+        {"__open_2", reinterpret_cast<const void*>(g_real.open_2), reinterpret_cast<uintptr_t>(HookOpen2)},
+        {"__open64_2", reinterpret_cast<const void*>(g_real.open64_2), reinterpret_cast<uintptr_t>(HookOpen64_2)},
+        {"fopen", reinterpret_cast<const void*>(g_real.fopen), reinterpret_cast<uintptr_t>(HookFopen)},
+        {"fopen64", reinterpret_cast<const void*>(g_real.fopen64), reinterpret_cast<uintptr_t>(HookFopen64)},
+    };
+
+    for (const auto& entry : hooks) {
+        if (strcmp(entry.name, name) == 0) {
+            return entry.real ? entry.hook : 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Store a GOT entry, unprotecting RELRO pages for the write only
+ */
+bool WriteSlot(uintptr_t* slot, uintptr_t value, bool relro) {
+    uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(slot) & ~(pageSize - 1));
+
+    if (relro && mprotect(page, pageSize, PROT_READ | PROT_WRITE) != 0) {
+        return false;
+    }
+    __atomic_store_n(slot, value, __ATOMIC_RELEASE);
+    if (relro) {
+        mprotect(page, pageSize, PROT_READ);
+    }
+    return true;
+}
+
+struct FindContext {
+    const char* path;
+    dl_phdr_info info;
+    bool found;
+};
+
+int FindObject(dl_phdr_info* info, size_t, void* data) {
+    auto* ctx = static_cast<FindContext*>(data);
+    if (!info->dlpi_name || !*info->dlpi_name) return 0;
+
+    char resolved[PATH_MAX];
+    if (!realpath(info->dlpi_name, resolved) || strcmp(resolved, ctx->path) != 0) return 0;
+
+    ctx->info = *info;
+    ctx->found = true;
+    return 1;
+}
+
+} // namespace
+
+PatchResult PatchObject(const std::string& path, const ObjectPolicy& policy, int dlopenFlags) {
+    PatchResult result;
+    std::call_once(g_realOnce, ResolveRealFunctions);
+
+    char resolved[PATH_MAX];
+    if (!realpath(path.c_str(), resolved)) {
+        result.error = std::string("cannot resolve ") + path + ": " + strerror(errno);
+        return result;
+    }
+
+    // Load the object (static constructors run here, unpatched) but not its
+    // Node module initializer; Node's own dlopen then reuses this handle
+    if (!dlopen(resolved, dlopenFlags ? dlopenFlags : RTLD_LAZY)) {
+        const char* error = dlerror();
+        result.error = error ? error : "dlopen failed";
+        return result;
+    }
+
+    FindContext ctx{resolved, {}, false};
+    dl_iterate_phdr(FindObject, &ctx);
+    if (!ctx.found) {
+        result.error = std::string("object not found after loading: ") + resolved;
+        return result;
+    }
+
+    uintptr_t base = ctx.info.dlpi_addr;
+    const ElfW(Dyn)* dynamic = nullptr;
+    uintptr_t relroStart = 0, relroEnd = 0;
+    std::vector<std::pair<uintptr_t, uintptr_t>> ranges;
+
+    for (ElfW(Half) i = 0; i < ctx.info.dlpi_phnum; ++i) {
+        const ElfW(Phdr)& phdr = ctx.info.dlpi_phdr[i];
+        uintptr_t start = base + phdr.p_vaddr;
+        if (phdr.p_type == PT_LOAD) {
+            ranges.emplace_back(start, start + phdr.p_memsz);
+        } else if (phdr.p_type == PT_DYNAMIC) {
+            dynamic = reinterpret_cast<const ElfW(Dyn)*>(start);
+        } else if (phdr.p_type == PT_GNU_RELRO) {
+            relroStart = start;
+            relroEnd = start + phdr.p_memsz;
+        }
+    }
+    if (!dynamic) {
+        result.error = "object has no dynamic section";
+        return result;
+    }
+
+    // glibc rebases these entries in place; other loaders may not
+    auto address = [base](ElfW(Addr) value) {
+        return value < base ? value + base : value;
+    };
+
+    const ElfW(Sym)* symtab = nullptr;
+    const char* strtab = nullptr;
+    const ElfW(Rela)* jmprel = nullptr;
+    const ElfW(Rela)* rela = nullptr;
+    size_t jmprelSize = 0, relaSize = 0;
+    ElfW(Sxword) pltrel = DT_RELA;
+
+    for (const ElfW(Dyn)* entry = dynamic; entry->d_tag != DT_NULL; ++entry) {
+        switch (entry->d_tag) {
+            case DT_SYMTAB: symtab = reinterpret_cast<const ElfW(Sym)*>(address(entry->d_un.d_ptr)); break;
+            case DT_STRTAB: strtab = reinterpret_cast<const char*>(address(entry->d_un.d_ptr)); break;
+            case DT_JMPREL: jmprel = reinterpret_cast<const ElfW(Rela)*>(address(entry->d_un.d_ptr)); break;
+            case DT_PLTRELSZ: jmprelSize = entry->d_un.d_val; break;
+            case DT_PLTREL: pltrel = static_cast<ElfW(Sxword)>(entry->d_un.d_val); break;
+            case DT_RELA: rela = reinterpret_cast<const ElfW(Rela)*>(address(entry->d_un.d_ptr)); break;
+            case DT_RELASZ: relaSize = entry->d_un.d_val; break;
+            default: break;
+        }
+    }
+    if (!symtab || !strtab) {
+        result.error = "object has no dynamic symbol table";
+        return result;
+    }
+    if (pltrel != DT_RELA) {
+        result.error = "REL-format PLT relocations are not supported";
+        return result;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(g_mutex);
+
+    PatchedObject* object = nullptr;
+    for (auto& existing : g_objects) {
+        if (existing->path == resolved) object = existing.get();
+    }
+    if (!object) {
+        g_objects.push_back(std::make_unique<PatchedObject>());
+        object = g_objects.back().get();
+        object->path = resolved;
+    }
+    object->ranges = ranges;
+    object->policy = policy;
+
+    auto patch = [&](const ElfW(Rela)* relocs, size_t bytes) {
+        for (size_t i = 0; relocs && i < bytes / sizeof(ElfW(Rela)); ++i) {
+            uint32_t type = DOTNOPE_R_TYPE(relocs[i].r_info);
+            if (type != kJumpSlot && type != kGlobDat) continue;
+
+            uintptr_t hook = HookFor(strtab + symtab[DOTNOPE_R_SYM(relocs[i].r_info)].st_name);
+            if (!hook) continue;
+
+            auto* slot = reinterpret_cast<uintptr_t*>(base + relocs[i].r_offset);
+            uintptr_t original = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+            if (original == hook) {
+                result.slots++;
+                continue;
+            }
+
+            uintptr_t at = reinterpret_cast<uintptr_t>(slot);
+            bool relro = at >= relroStart && at < relroEnd;
+            if (!WriteSlot(slot, hook, relro)) {
+                result.error = std::string("cannot make GOT writable: ") + strerror(errno);
+                continue;
+            }
+            object->slots.push_back({slot, original, relro});
+            result.slots++;
+        }
+    };
+    patch(jmprel, jmprelSize);
+    patch(rela, relaSize);
+
+    result.ok = result.error.empty();
+    return result;
+}
+
+void UnpatchAll() {
+    std::unique_lock<std::shared_mutex> lock(g_mutex);
+    for (auto& object : g_objects) {
+        for (const auto& patched : object->slots) {
+            WriteSlot(patched.slot, patched.original, patched.relro);
+        }
+        object->slots.clear();
+    }
+}
+
+#else // !DOTNOPE_GOT_PATCHING
+
+PatchResult PatchObject(const std::string&, const ObjectPolicy&, int) {
+    PatchResult result;
+    result.error = "GOT patching is only supported on Linux x86-64 and AArch64";
+    return result;
+}
+
+void UnpatchAll() {}
+
+#endif // DOTNOPE_GOT_PATCHING
+
+/**
+ * Read a list of variable names from a policy object property
+ */
+static VarSet ReadVarSet(const Napi::Object& policy, const char* key) {
+    VarSet set;
+    Napi::Value value = policy.Get(key);
+    if (!value.IsArray()) {
+        return set;
+    }
+
+    Napi::Array names = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < names.Length(); ++i) {
+        Napi::Value item = names.Get(i);
+        if (!item.IsString()) continue;
+
+        std::string name = item.As<Napi::String>().Utf8Value();
+        if (name == "*") {
+            set.all = true;
+        } else {
+            set.names.insert(std::move(name));
+        }
+    }
+    return set;
+}
+
+/**
+ * Patch a native module with a policy
+ */
+Napi::Value PatchModule(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsObject()) {
+        result.Set("ok", Napi::Boolean::New(env, false));
+        result.Set("slots", Napi::Number::New(env, 0));
+        result.Set("error", Napi::String::New(env, "expected (path, policy[, flags])"));
+        return result;
+    }
+
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    Napi::Object policyObject = info[1].As<Napi::Object>();
+
+    ObjectPolicy policy;
+    policy.read = ReadVarSet(policyObject, "allowed");
+    policy.write = ReadVarSet(policyObject, "canWrite");
+    policy.remove = ReadVarSet(policyObject, "canDelete");
+    Napi::Value protectProc = policyObject.Get("protectProc");
+    policy.protectProc = !protectProc.IsBoolean() || protectProc.As<Napi::Boolean>().Value();
+
+    int flags = 0;
+    if (info.Length() > 2 && info[2].IsNumber()) {
+        flags = info[2].As<Napi::Number>().Int32Value();
+    }
+
+    PatchResult patched = PatchObject(path, policy, flags);
+    result.Set("ok", Napi::Boolean::New(env, patched.ok));
+    result.Set("slots", Napi::Number::New(env, patched.slots));
+    result.Set("error", patched.error.empty() ? env.Null() : Napi::String::New(env, patched.error));
+    return result;
+}
+
+/**
+ * Restore all patched modules
+ */
+Napi::Value UnpatchModules(const Napi::CallbackInfo& info) {
+    UnpatchAll();
+    return Napi::Boolean::New(info.Env(), true);
+}
+
+/**
+ * Per-object allowed/denied counters
+ */
+Napi::Value GetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Array result = Napi::Array::New(env);
+
+#ifdef DOTNOPE_GOT_PATCHING
+    std::shared_lock<std::shared_mutex> lock(g_mutex);
+    uint32_t index = 0;
+    for (const auto& object : g_objects) {
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("path", Napi::String::New(env, object->path));
+        entry.Set("slots", Napi::Number::New(env, static_cast<double>(object->slots.size())));
+        entry.Set("allowed", Napi::Number::New(env, static_cast<double>(object->allowed.load(std::memory_order_relaxed))));
+        entry.Set("denied", Napi::Number::New(env, static_cast<double>(object->denied.load(std::memory_order_relaxed))));
+        result.Set(index++, entry);
+    }
+
+    Napi::Object unattributed = Napi::Object::New(env);
+    unattributed.Set("path", env.Null());
+    unattributed.Set("slots", Napi::Number::New(env, 0));
+    unattributed.Set("allowed", Napi::Number::New(env, static_cast<double>(g_unattributedAllowed.load(std::memory_order_relaxed))));
+    unattributed.Set("denied", Napi::Number::New(env, static_cast<double>(g_unattributedDenied.load(std::memory_order_relaxed))));
+    result.Set(index, unattributed);
+#endif
+
+    return result;
+}
+
+} // namespace GotPatcher
+} // namespace dotnope
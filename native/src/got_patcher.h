@@ -0,0 +1,94 @@
+/**
+ * got_patcher.h - In-process GOT/PLT patching of native addons
+ *
+ * Redirects the getenv/setenv/open family of imports of individual .node
+ * shared objects to dotnope's hooks by rewriting their GOT entries, so only
+ * third-party native code pays for interposition and no LD_PRELOAD launcher
+ * is needed. Each hook attributes the call to the patched object containing
+ * its return address and applies that object's policy.
+ *
+ * Linux (x86-64, AArch64) only; elsewhere patching reports "unsupported".
+ */
+
+#ifndef DOTNOPE_GOT_PATCHER_H
+#define DOTNOPE_GOT_PATCHER_H
+
+#include <napi.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace dotnope {
+namespace GotPatcher {
+
+/**
+ * Transparent hash so lookups by string_view do not allocate
+ */
+struct NameHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+};
+
+/**
+ * Set of variable names, or every name
+ */
+struct VarSet {
+    bool all = false;
+    std::unordered_set<std::string, NameHash, std::equal_to<>> names;
+
+    bool Contains(std::string_view name) const;
+};
+
+/**
+ * Policy applied to calls made by one patched object
+ */
+struct ObjectPolicy {
+    VarSet read;            // getenv, secure_getenv
+    VarSet write;           // setenv, putenv
+    VarSet remove;          // unsetenv
+    bool protectProc = true;  // block /proc/<pid>/environ opens
+};
+
+struct PatchResult {
+    bool ok = false;
+    int slots = 0;          // GOT entries redirected
+    std::string error;
+};
+
+/**
+ * Load (if needed) and patch the shared object at path.
+ * dlopenFlags is used when the object is not loaded yet; the handle is
+ * kept so that a later dlopen of the same file (Node's) finds the patched
+ * object before running its module initializer.
+ * Patching an object twice replaces its policy.
+ */
+PatchResult PatchObject(const std::string& path, const ObjectPolicy& policy, int dlopenFlags);
+
+/**
+ * Restore every patched GOT entry to its original value
+ */
+void UnpatchAll();
+
+/**
+ * N-API: patchNativeModule(path, { allowed, canWrite, canDelete, protectProc }, dlopenFlags?)
+ * Returns { ok, slots, error }
+ */
+Napi::Value PatchModule(const Napi::CallbackInfo& info);
+
+/**
+ * N-API: unpatchNativeModules()
+ */
+Napi::Value UnpatchModules(const Napi::CallbackInfo& info);
+
+/**
+ * N-API: getNativePatchStats()
+ * Returns [{ path, slots, allowed, denied }], the last entry (path null)
+ * counting calls that could not be attributed to a patched object
+ */
+Napi::Value GetStats(const Napi::CallbackInfo& info);
+
+} // namespace GotPatcher
+} // namespace dotnope
+
+#endif // DOTNOPE_GOT_PATCHER_H
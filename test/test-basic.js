@@ -207,6 +207,61 @@ describe('dotnope', () => {
                 cleanup(fixturesDir);
             }
         });
+        test('should resolve the caller a fixed number of times per spread of process.env', () => {
+            const fixturesDir = getUniqueFixturesDir();
+            const stackParser = require('../lib/stack-parser');
+            const originalGetCallingPackage = stackParser.getCallingPackage;
+            try {
+                const pkgPath = createTestPackageJson(fixturesDir, {
+                    name: 'test-app',
+                    environmentWhitelist: {
+                        'spread-package': { allowed: ['SPREAD_*'] }
+                    }
+                });
+
+                // Only filtered enumerations reuse their attribution, so
+                // spread from a package rather than the app
+                const spreadPackageDir = path.join(fixturesDir, 'node_modules/spread-package');
+                fs.mkdirSync(spreadPackageDir, { recursive: true });
+                fs.writeFileSync(path.join(spreadPackageDir, 'package.json'),
+                    JSON.stringify({ name: 'spread-package', version: '1.0.0' }));
+                fs.writeFileSync(path.join(spreadPackageDir, 'index.js'),
+                    "'use strict';\nmodule.exports = () => ({ ...process.env });\n");
+
+                let resolutions = 0;
+                // Skip this wrapper's frame too, or the test file is the caller
+                stackParser.getCallingPackage = (skipFrames = 0) => {
+                    resolutions++;
+                    return originalGetCallingPackage(skipFrames + 2);
+                };
+
+                const dotnope = require('../index');
+                const handle = dotnope.enableStrictEnv({ strictLoadOrder: false, configPath: pkgPath });
+
+                const names = [];
+                for (let i = 0; i < 8; i++) {
+                    names.push(`SPREAD_${i}`);
+                    process.env[`SPREAD_${i}`] = String(i);
+                }
+
+                const spreadEnv = require(spreadPackageDir);
+                resolutions = 0;
+                const copy = spreadEnv();
+
+                for (const name of names) {
+                    assert.strictEqual(copy[name], name.slice('SPREAD_'.length));
+                }
+                // The ownKeys call plus the first key's descriptor and get,
+                // which are checked against its call site; not one per key
+                assert.ok(resolutions <= 3, `expected three attributions per spread, got ${resolutions}`);
+
+                const token = handle.getToken();
+                handle.disable(token);
+            } finally {
+                stackParser.getCallingPackage = originalGetCallingPackage;
+                cleanup(fixturesDir);
+            }
+        });
     });
 
     describe('disableStrictEnv', () => {
@@ -289,6 +344,16 @@ describe('config-loader', () => {
             cleanup(fixturesDir);
         }
     });
+
+    test('should normalize denyMode', () => {
+        const configLoader = require('../lib/config-loader');
+
+        assert.strictEqual(configLoader.normalizeConfig({}).options.denyMode, 'throw');
+        assert.strictEqual(
+            configLoader.normalizeConfig({ '__options__': { denyMode: 'silent' } }).options.denyMode, 'silent');
+        assert.strictEqual(
+            configLoader.normalizeConfig({ '__options__': { denyMode: 'bogus' } }).options.denyMode, 'throw');
+    });
 });
 
 describe('stack-parser', () => {
@@ -384,3 +449,317 @@ describe('dependency-resolver', () => {
         assert.strictEqual(result, true);
     });
 });
+
+describe('decision-cache', () => {
+    let decisionCache;
+
+    beforeEach(() => {
+        clearDotnopeCache();
+        decisionCache = require('../lib/decision-cache');
+    });
+
+    afterEach(() => {
+        decisionCache.clear();
+    });
+
+    test('should evaluate once per (package, var, operation) within an epoch', () => {
+        let calls = 0;
+        const evaluate = (pkg, envVar, op) => {
+            calls++;
+            return envVar === 'ALLOWED_VAR' && op === 'read';
+        };
+
+        assert.strictEqual(decisionCache.decide('pkg', 'ALLOWED_VAR', 'read', 1, evaluate), true);
+        assert.strictEqual(decisionCache.decide('pkg', 'ALLOWED_VAR', 'read', 1, evaluate), true);
+        assert.strictEqual(decisionCache.decide('pkg', 'ALLOWED_VAR', 'write', 1, evaluate), false);
+        assert.strictEqual(decisionCache.decide('pkg', 'ALLOWED_VAR', 'write', 1, evaluate), false);
+        assert.strictEqual(calls, 2);
+    });
+
+    test('should re-evaluate after the policy epoch changes', () => {
+        const configLoader = require('../lib/config-loader');
+        let allowed = true;
+        const evaluate = () => allowed;
+
+        const epoch = configLoader.getPolicyEpoch();
+        assert.strictEqual(decisionCache.decide('pkg', 'VAR', 'read', epoch, evaluate), true);
+
+        allowed = false;
+        assert.strictEqual(decisionCache.decide('pkg', 'VAR', 'read', epoch, evaluate), true);
+
+        configLoader.loadConfig(null, { 'pkg': [] });
+        assert.notStrictEqual(configLoader.getPolicyEpoch(), epoch);
+        assert.strictEqual(decisionCache.decide('pkg', 'VAR', 'read', configLoader.getPolicyEpoch(), evaluate), false);
+    });
+
+    test('should not cache unknown operations', () => {
+        let calls = 0;
+        const evaluate = () => {
+            calls++;
+            return false;
+        };
+
+        decisionCache.decide('pkg', 'VAR', 'define', 1, evaluate);
+        decisionCache.decide('pkg', 'VAR', 'define', 1, evaluate);
+        assert.strictEqual(calls, 2);
+    });
+});
+
+describe('access-stats', () => {
+    let accessStats;
+
+    beforeEach(() => {
+        clearDotnopeCache();
+        accessStats = require('../lib/access-stats');
+    });
+
+    afterEach(() => {
+        accessStats.clear();
+    });
+
+    test('should count accesses per (package, var, operation)', () => {
+        accessStats.record('pkg', 'VAR', 'read');
+        accessStats.record('pkg', 'VAR', 'read');
+        accessStats.record('pkg', 'VAR', 'write');
+        accessStats.record('other', 'VAR', 'read');
+
+        assert.deepStrictEqual(accessStats.getSnapshot(), {
+            'pkg:VAR:read': 2,
+            'pkg:VAR:write': 1,
+            'other:VAR:read': 1
+        });
+    });
+
+    test('should report only increments since the previous delta', () => {
+        accessStats.record('pkg', 'A', 'read');
+        accessStats.record('pkg', 'B', 'read');
+        assert.deepStrictEqual(accessStats.getDelta(), { 'pkg:A:read': 1, 'pkg:B:read': 1 });
+        assert.deepStrictEqual(accessStats.getDelta(), {});
+
+        accessStats.record('pkg', 'A', 'read');
+        accessStats.record('pkg', 'A', 'read');
+        assert.deepStrictEqual(accessStats.getDelta(), { 'pkg:A:read': 2 });
+        assert.strictEqual(accessStats.getSnapshot()['pkg:A:read'], 3);
+    });
+
+    test('should format counters for Prometheus with escaped labels', () => {
+        accessStats.record('@scope/pkg', 'VAR', 'delete');
+        accessStats.record('odd"name', 'VAR', 'read');
+
+        const text = accessStats.formatPrometheus('env_total');
+        assert.ok(text.startsWith('# HELP env_total '));
+        assert.ok(text.includes('# TYPE env_total counter\n'));
+        assert.ok(text.includes('env_total{package="@scope/pkg",variable="VAR",operation="delete"} 1\n'));
+        assert.ok(text.includes('env_total{package="odd\\"name",variable="VAR",operation="read"} 1\n'));
+    });
+
+    test('should only count accesses past the variable cap', () => {
+        for (let i = 0; i < 65536; i++) {
+            accessStats.record('pkg', `VAR_${i}`, 'read');
+        }
+        assert.strictEqual(accessStats.getOverflow(), 0);
+
+        for (let i = 0; i < 1000; i++) {
+            accessStats.record('pkg', `PROBE_${i}`, 'read');
+        }
+        accessStats.record('pkg', 'VAR_0', 'read');
+
+        assert.strictEqual(accessStats.getOverflow(), 1000);
+        const snapshot = accessStats.getSnapshot();
+        assert.strictEqual(snapshot['pkg:VAR_0:read'], 2);
+        assert.strictEqual(snapshot['pkg:PROBE_0:read'], undefined);
+
+        accessStats.clear();
+        assert.strictEqual(accessStats.getOverflow(), 0);
+    });
+});
+
+describe('perf-stats', () => {
+    let perfStats;
+
+    beforeEach(() => {
+        clearDotnopeCache();
+        perfStats = require('../lib/perf-stats');
+    });
+
+    afterEach(() => {
+        perfStats.disable();
+    });
+
+    function timedCheck(packageName, envVar, allowed) {
+        assert.strictEqual(perfStats.begin(), true);
+        perfStats.attribute(packageName, null);
+        perfStats.mark(perfStats.PHASE_POLICY);
+        perfStats.end(envVar, 'read', 'get', allowed);
+    }
+
+    test('should record nothing unless enabled', () => {
+        assert.strictEqual(perfStats.begin(), false);
+        assert.strictEqual(perfStats.getSnapshot(), null);
+    });
+
+    test('should record phases, totals and packages for the outermost check only', () => {
+        perfStats.enable({ slowCheckThresholdMs: 1000 });
+
+        timedCheck('pkg', 'A', true);
+        assert.strictEqual(perfStats.begin(), true);
+        perfStats.attribute('outer', null);
+        timedCheck('inner', 'B', true);
+        perfStats.end('C', 'read', 'get', true);
+
+        const stats = perfStats.getSnapshot();
+        assert.strictEqual(stats.total.count, 2);
+        assert.strictEqual(stats.phases.attribution.count, 2);
+        assert.deepStrictEqual(Object.keys(stats.packages).sort(), ['outer', 'pkg']);
+        assert.ok(stats.total.p99 >= stats.total.p50);
+        assert.deepStrictEqual(stats.slowChecks, []);
+    });
+
+    test('should keep the most recent slow checks, oldest first', () => {
+        perfStats.enable({ slowCheckThresholdMs: 0, slowCheckLogSize: 2 });
+
+        timedCheck('pkg', 'A', true);
+        timedCheck('pkg', 'B', false);
+        timedCheck('pkg', 'C', true);
+
+        const slowChecks = perfStats.getSnapshot().slowChecks;
+        assert.deepStrictEqual(slowChecks.map(entry => entry.envVar), ['B', 'C']);
+        assert.strictEqual(slowChecks[0].allowed, false);
+        assert.strictEqual(slowChecks[0].packageName, 'pkg');
+        assert.strictEqual(typeof slowChecks[0].phases.policy, 'number');
+        assert.strictEqual(typeof slowChecks[0].stack, 'string');
+    });
+});
+
+describe('policy-compiler', () => {
+    let policyCompiler;
+    let configLoader;
+
+    beforeEach(() => {
+        clearDotnopeCache();
+        policyCompiler = require('../lib/policy-compiler');
+        configLoader = require('../lib/config-loader');
+    });
+
+    afterEach(() => {
+        configLoader.clearCache();
+        require('../lib/dependency-resolver').clearCache();
+    });
+
+    test('should compile per-operation grants and wildcards', () => {
+        const { policy } = configLoader.normalizeConfig({
+            'reader': ['A', 'B'],
+            'writer': { allowed: ['A'], canWrite: ['A'], canDelete: ['*'] },
+            'everything': ['*']
+        });
+
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'reader', 'A', 'read'), true);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'reader', 'C', 'read'), false);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'reader', 'A', 'write'), false);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'writer', 'A', 'write'), true);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'writer', 'B', 'write'), false);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'writer', 'ANY', 'delete'), true);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'everything', 'ANY', 'read'), true);
+        assert.strictEqual(policyCompiler.hasWildcard(policy, 'everything', 'read'), true);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'unknown', 'A', 'read'), false);
+        assert.ok(Object.isFrozen(policy));
+    });
+
+    test('should expand peer dependency grants at compile time', () => {
+        const fixturesDir = getUniqueFixturesDir();
+        const originalCwd = process.cwd();
+        try {
+            createTestPackageJson(path.join(fixturesDir, 'node_modules', 'parent'), {
+                name: 'parent',
+                dependencies: { 'child': '1.0.0', 'excluded': '1.0.0' }
+            });
+            createTestPackageJson(fixturesDir, { name: 'app' });
+            process.chdir(fixturesDir);
+
+            const { policy } = configLoader.normalizeConfig({
+                'parent': { allowed: ['TOKEN'], allowPeerDependencies: true, excludePeerDependencies: ['excluded'] }
+            });
+
+            assert.strictEqual(policyCompiler.isAllowed(policy, 'child', 'TOKEN', 'read'), true);
+            assert.strictEqual(policyCompiler.isAllowed(policy, 'child', 'TOKEN', 'write'), false);
+            assert.strictEqual(policyCompiler.isAllowed(policy, 'excluded', 'TOKEN', 'read'), false);
+        } finally {
+            process.chdir(originalCwd);
+            cleanup(fixturesDir);
+        }
+    });
+
+    test('should grant access through patterns', () => {
+        const { policy } = configLoader.normalizeConfig({
+            'otel': ['OTEL_*'],
+            'aws': { allowed: ['AWS_*', 'REGION'], canWrite: ['AWS_SDK_*'] },
+            'proxy': ['*_PROXY']
+        });
+
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'otel', 'OTEL_SERVICE_NAME', 'read'), true);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'otel', 'OTEL', 'read'), false);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'otel', 'AWS_REGION', 'read'), false);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'aws', 'AWS_SDK_LOAD_CONFIG', 'write'), true);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'aws', 'AWS_REGION', 'write'), false);
+        assert.strictEqual(policyCompiler.isAllowed(policy, 'proxy', 'HTTPS_PROXY', 'read'), true);
+        assert.strictEqual(policyCompiler.isAllowed(structuredClone(policy), 'otel', 'OTEL_X', 'read'), true);
+    });
+
+    test('should classify public-tier variables', () => {
+        const { policy, options } = configLoader.normalizeConfig({
+            '__options__': { publicVars: ['APP_*', 'BUILD_ID'], autoPublicVars: true, publicAuditRate: 0.5 }
+        });
+
+        assert.strictEqual(options.publicAuditRate, 0.5);
+        assert.strictEqual(policyCompiler.isPublic(policy, 'BUILD_ID'), true);
+        assert.strictEqual(policyCompiler.isPublic(policy, 'APP_MODE'), true);
+        assert.strictEqual(policyCompiler.isPublic(policy, 'APP_DB_PASSWORD'), false);
+        assert.strictEqual(policyCompiler.isPublic(policy, 'APP_DATABASE_URL'), false);
+        assert.strictEqual(policyCompiler.isPublic(policy, 'NODE_ENV'), true);
+        assert.strictEqual(policyCompiler.isPublic(policy, 'LC_ALL'), true);
+        assert.strictEqual(policyCompiler.isPublic(policy, 'AWS_SECRET_ACCESS_KEY'), false);
+
+        const { policy: strict } = configLoader.normalizeConfig({});
+        assert.strictEqual(policyCompiler.isPublic(strict, 'NODE_ENV'), false);
+    });
+
+    test('should accept a structured-cloned policy from getSerializableConfig', () => {
+        configLoader.loadConfig(null, { 'pkg': { allowed: ['A'], canWrite: ['A'] } });
+        const serialized = structuredClone(configLoader.getSerializableConfig());
+
+        configLoader.clearCache();
+        configLoader.loadConfig(null, serialized);
+
+        assert.strictEqual(configLoader.getConfig().pkg.allowed[0], 'A');
+        assert.strictEqual(policyCompiler.isAllowed(configLoader.getPolicy(), 'pkg', 'A', 'write'), true);
+        assert.strictEqual(policyCompiler.isAllowed(configLoader.getPolicy(), 'pkg', 'B', 'read'), false);
+    });
+});
+
+describe('env-pattern', () => {
+    let envPattern;
+
+    beforeEach(() => {
+        clearDotnopeCache();
+        envPattern = require('../lib/env-pattern');
+    });
+
+    test('should treat entries containing * other than * itself as patterns', () => {
+        assert.strictEqual(envPattern.isPattern('OTEL_*'), true);
+        assert.strictEqual(envPattern.isPattern('*'), false);
+        assert.strictEqual(envPattern.isPattern('PATH'), false);
+    });
+
+    test('should report every matching pattern', () => {
+        const matcher = envPattern.createMatcher(['AWS_*', 'AWS_SDK_*', '*_PROXY', 'A*B*C']);
+
+        assert.deepStrictEqual(matcher.match('AWS_SDK_LOAD_CONFIG'), [0, 1]);
+        assert.deepStrictEqual(matcher.match('AWS_REGION'), [0]);
+        assert.deepStrictEqual(matcher.match('HTTP_PROXY'), [2]);
+        assert.deepStrictEqual(matcher.match('AxBxC'), [3]);
+        assert.deepStrictEqual(matcher.match('ABx'), []);
+        assert.deepStrictEqual(matcher.match('AWS'), []);
+        // Repeated lookups walk the memoized states
+        assert.deepStrictEqual(matcher.match('AWS_SDK_LOAD_CONFIG'), [0, 1]);
+    });
+});
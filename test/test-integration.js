@@ -62,6 +62,12 @@ module.exports = {
     },
     checkEnvVar: function(name) {
         return name in process.env;
+    },
+    setEnvVar: function(name, value) {
+        process.env[name] = value;
+    },
+    deleteEnvVar: function(name) {
+        delete process.env[name];
     }
 };`
     );
@@ -288,4 +294,151 @@ describe('integration tests', { concurrency: false }, () => {
             cleanup(fixturesDir);
         }
     });
+
+    test('should attribute access through module-scoped process views', () => {
+        const fixturesDir = getUniqueFixturesDir();
+        try {
+            const { mainPkgPath, fakePackageDir } = setupMockProject(fixturesDir, {
+                'fake-package': {
+                    allowed: ['ALLOWED_VAR'],
+                    allowPeerDependencies: false
+                }
+            });
+
+            process.env.ALLOWED_VAR = 'allowed';
+            process.env.FORBIDDEN_VAR = 'forbidden';
+            process.chdir(fixturesDir);
+
+            const dotnope = require('../index');
+            const handle = dotnope.enableStrictEnv({
+                strictLoadOrder: false,
+                configPath: mainPkgPath,
+                moduleScopedEnv: true
+            });
+
+            delete require.cache[require.resolve(fakePackageDir)];
+            const fakePackage = require(fakePackageDir);
+
+            assert.strictEqual(fakePackage.getEnvVar('ALLOWED_VAR'), 'allowed');
+            assert.throws(() => {
+                fakePackage.getEnvVar('FORBIDDEN_VAR');
+            }, (err) => {
+                assert.strictEqual(err.code, 'ERR_DOTNOPE_UNAUTHORIZED');
+                assert.strictEqual(err.packageName, 'fake-package');
+                return true;
+            });
+
+            const token = handle.getToken();
+            handle.disable(token);
+
+            // Views are no longer injected once disabled
+            assert.ok(!require('module').wrap('').includes('process)'));
+        } finally {
+            cleanup(fixturesDir);
+        }
+    });
+
+    test('should let any package read public-tier variables', () => {
+        const fixturesDir = getUniqueFixturesDir();
+        try {
+            const { mainPkgPath, fakePackageDir } = setupMockProject(fixturesDir, {
+                '__options__': {
+                    publicVars: ['APP_*'],
+                    autoPublicVars: true
+                }
+                // fake-package is NOT whitelisted
+            });
+
+            process.env.NODE_ENV = 'production';
+            process.env.APP_MODE = 'worker';
+            process.env.APP_API_KEY = 'secret';
+            process.chdir(fixturesDir);
+
+            const dotnope = require('../index');
+            const handle = dotnope.enableStrictEnv({
+                strictLoadOrder: false,
+                configPath: mainPkgPath,
+                moduleScopedEnv: true
+            });
+
+            delete require.cache[require.resolve(fakePackageDir)];
+            const fakePackage = require(fakePackageDir);
+
+            assert.strictEqual(fakePackage.getEnvVar('NODE_ENV'), 'production');
+            assert.strictEqual(fakePackage.getEnvVar('APP_MODE'), 'worker');
+
+            // Secret-looking names are never made public by a pattern
+            assert.throws(() => {
+                fakePackage.getEnvVar('APP_API_KEY');
+            }, (err) => {
+                assert.strictEqual(err.code, 'ERR_DOTNOPE_UNAUTHORIZED');
+                return true;
+            });
+
+            const token = handle.getToken();
+            handle.disable(token);
+        } finally {
+            cleanup(fixturesDir);
+        }
+    });
+
+    test('should serve reads from the env snapshot and refuse writes once sealed', () => {
+        const fixturesDir = getUniqueFixturesDir();
+        try {
+            const { mainPkgPath, fakePackageDir } = setupMockProject(fixturesDir, {
+                'fake-package': {
+                    allowed: ['SNAPSHOT_VAR'],
+                    canWrite: ['SNAPSHOT_VAR'],
+                    canDelete: ['SNAPSHOT_VAR']
+                }
+            });
+
+            process.env.SNAPSHOT_VAR = 'before';
+            process.chdir(fixturesDir);
+
+            const dotnope = require('../index');
+            const handle = dotnope.enableStrictEnv({
+                strictLoadOrder: false,
+                configPath: mainPkgPath,
+                moduleScopedEnv: true,
+                envSnapshot: true
+            });
+
+            delete require.cache[require.resolve(fakePackageDir)];
+            const fakePackage = require(fakePackageDir);
+
+            assert.strictEqual(fakePackage.getEnvVar('SNAPSHOT_VAR'), 'before');
+
+            fakePackage.setEnvVar('SNAPSHOT_VAR', 'written');
+            assert.strictEqual(fakePackage.getEnvVar('SNAPSHOT_VAR'), 'written');
+
+            fakePackage.deleteEnvVar('SNAPSHOT_VAR');
+            assert.strictEqual(fakePackage.checkEnvVar('SNAPSHOT_VAR'), false);
+            assert.strictEqual(fakePackage.getEnvVar('SNAPSHOT_VAR'), undefined);
+
+            fakePackage.setEnvVar('SNAPSHOT_VAR', 'after');
+            assert.strictEqual(handle.resync(), true);
+            assert.strictEqual(fakePackage.getEnvVar('SNAPSHOT_VAR'), 'after');
+
+            // The fake package is strict mode code, so refused writes throw
+            handle.seal();
+            assert.throws(() => {
+                fakePackage.setEnvVar('SNAPSHOT_VAR', 'sealed');
+            }, TypeError);
+            assert.throws(() => {
+                fakePackage.deleteEnvVar('SNAPSHOT_VAR');
+            }, TypeError);
+            assert.strictEqual(handle.resync(), false);
+            assert.strictEqual(fakePackage.getEnvVar('SNAPSHOT_VAR'), 'after');
+
+            const token = handle.getToken();
+            handle.disable(token);
+
+            // disable() lifts the seal along with the proxy
+            process.env.SNAPSHOT_VAR = 'unsealed';
+            assert.strictEqual(process.env.SNAPSHOT_VAR, 'unsealed');
+        } finally {
+            cleanup(fixturesDir);
+        }
+    });
 });
@@ -419,6 +419,191 @@ describe('Preload Generator', () => {
         assert.ok(policy.includes('LOG_LEVEL'), 'Should include LOG_LEVEL');
     });
 
+    test('should compile policy to a binary image', () => {
+        const preloadGen = require('../lib/preload-generator');
+
+        const config = {
+            'axios': { allowed: ['HTTP_PROXY', 'HTTPS_PROXY'], canWrite: [] },
+            'config': { allowed: ['NODE_ENV'], canWrite: ['LOG_LEVEL'] }
+        };
+
+        const image = preloadGen.compilePolicy(config);
+        assert.strictEqual(image.toString('latin1', 0, 8), 'DNPOLICY');
+
+        const decoded = preloadGen.readCompiledPolicy(image);
+        assert.strictEqual(decoded.allowAll, false);
+        assert.deepStrictEqual(decoded.vars, ['HTTPS_PROXY', 'HTTP_PROXY', 'LOG_LEVEL', 'NODE_ENV']);
+        assert.deepStrictEqual(decoded.packages.config.vars, ['LOG_LEVEL', 'NODE_ENV']);
+        assert.deepStrictEqual(decoded.packages.axios.vars, ['HTTPS_PROXY', 'HTTP_PROXY']);
+    });
+
+    test('should mark wildcard policies and reject corrupt images', () => {
+        const preloadGen = require('../lib/preload-generator');
+
+        const image = preloadGen.compilePolicy({
+            'dotenv': { allowed: ['*'], canWrite: [] },
+            'axios': { allowed: ['HTTP_PROXY'], canWrite: [] }
+        });
+
+        const decoded = preloadGen.readCompiledPolicy(image);
+        assert.strictEqual(decoded.allowAll, true);
+        assert.strictEqual(decoded.packages.dotenv.wildcard, true);
+
+        image[image.length - 2] ^= 0xff;
+        assert.throws(() => preloadGen.readCompiledPolicy(image), /corrupt/);
+    });
+
+    test('should publish policies into alternating segment slots', () => {
+        const preloadGen = require('../lib/preload-generator');
+        const os = require('os');
+        const segPath = path.join(os.tmpdir(), `dotnope-seg-${process.pid}-${Date.now()}`);
+
+        try {
+            preloadGen.createPolicySegment(segPath, { axios: { allowed: ['HTTP_PROXY'] } }, { slotSize: 4096 });
+            const generation = preloadGen.publishPolicySegment(segPath, { axios: { allowed: ['HTTP_PROXY', 'NO_PROXY'] } });
+            assert.strictEqual(generation, 1);
+
+            const segment = fs.readFileSync(segPath);
+            assert.strictEqual(segment.readUInt32LE(16), 1);
+            const slotSize = segment.readUInt32LE(12);
+            const active = segment.subarray(64 + slotSize);
+            const decoded = preloadGen.readCompiledPolicy(active.subarray(0, active.readUInt32LE(16)));
+            assert.deepStrictEqual(decoded.vars, ['HTTP_PROXY', 'NO_PROXY']);
+
+            assert.throws(
+                () => preloadGen.publishPolicySegment(segPath, { big: { allowed: Array.from({ length: 500 }, (_, i) => `VAR_${i}`) } }),
+                /exceeds segment slot size/
+            );
+        } finally {
+            fs.rmSync(segPath, { force: true });
+        }
+    });
+
+    test('should generate a perfect-hash baked policy header', () => {
+        const preloadGen = require('../lib/preload-generator');
+        const names = Array.from({ length: 1000 }, (_, i) => `VAR_${i}`);
+        const header = preloadGen.generateBakedPolicyHeader({ big: { allowed: names } });
+
+        const tableSize = Number(/#define DNP_BAKED_TABLE_SIZE (\d+)/.exec(header)[1]);
+        const section = (name) => header.slice(header.indexOf(name), header.indexOf('};', header.indexOf(name)));
+        const displacements = section('dnp_baked_displacements[').match(/^\s+[\d, ]+,$/gm).join('').match(/\d+/g).map(Number);
+        const slots = section('dnp_baked_names[').match(/^\s+(NULL|"[^"]*"),$/gm).map(line => line.trim().slice(0, -1));
+
+        const fmix = (h) => {
+            h ^= h >>> 16; h = Math.imul(h, 0x85ebca6b);
+            h ^= h >>> 13; h = Math.imul(h, 0xc2b2ae35);
+            return (h ^ (h >>> 16)) >>> 0;
+        };
+        for (const name of names) {
+            let hash = 0x811c9dc5;
+            for (const byte of Buffer.from(name)) hash = Math.imul(hash ^ byte, 0x01000193);
+            hash >>>= 0;
+            const d = displacements[hash & (displacements.length - 1)];
+            const slot = fmix(hash ^ Math.imul(d, 0x9e3779b9)) & (tableSize - 1);
+            assert.strictEqual(slots[slot], `"${name}"`);
+        }
+
+        assert.match(header, /#define DNP_BAKED_ALLOW_ALL 0/);
+        assert.match(preloadGen.generateBakedPolicyHeader({ a: { allowed: ['*'] } }), /#define DNP_BAKED_ALLOW_ALL 1/);
+    });
+
+    test('should parse preload stats regions', () => {
+        const preloadGen = require('../lib/preload-generator');
+
+        // Header (128 bytes) plus two variable slots (136 bytes each)
+        const buf = Buffer.alloc(128 + 2 * 136);
+        buf.write('DNPSTATS', 0, 'latin1');
+        buf.writeUInt32LE(1, 8);
+        buf.writeUInt32LE(4242, 12);
+        buf.writeUInt32LE(2, 16);
+        buf.writeUInt32LE(64, 20);
+        buf.writeBigUInt64LE(3n, 32 + 8);       // getenv allowed
+        buf.writeBigUInt64LE(2n, 32);           // getenv denied
+
+        for (const at of [128, 128 + 136]) {
+            buf.writeUInt32LE(2, at);
+            buf.write('SECRET', at + 8);
+            buf.writeBigUInt64LE(1n, at + 72);  // getenv denied
+        }
+
+        const stats = preloadGen.parsePreloadStats(buf);
+        assert.strictEqual(stats.pid, 4242);
+        assert.deepStrictEqual(stats.totals.getenv, { allowed: 3, denied: 2 });
+        assert.deepStrictEqual(Object.keys(stats.vars), ['SECRET']);
+        assert.strictEqual(stats.vars.SECRET.getenv.denied, 2);
+
+        assert.throws(() => preloadGen.parsePreloadStats(Buffer.alloc(128)), /Not a preload stats region/);
+    });
+
+    test('should reduce the environment to whitelisted and runtime variables', () => {
+        const preloadGen = require('../lib/preload-generator');
+        const env = {
+            PATH: '/bin', HTTP_PROXY: 'p', LOG_LEVEL: 'debug', NODE_OPTIONS: '--enable-source-maps',
+            LC_CTYPE: 'C', DOTNOPE_POLICY: 'x', APP_PORT: '80', AWS_SECRET_ACCESS_KEY: 'secret'
+        };
+        const config = {
+            axios: { allowed: ['HTTP_PROXY'], canWrite: [] },
+            logger: { allowed: [], canWrite: ['LOG_LEVEL'] }
+        };
+
+        const minimal = preloadGen.generateMinimalEnv(config, env, { keep: ['APP_PORT'] });
+        assert.deepStrictEqual(Object.keys(minimal).sort(), [
+            'APP_PORT', 'DOTNOPE_POLICY', 'HTTP_PROXY', 'LC_CTYPE', 'LOG_LEVEL', 'NODE_OPTIONS', 'PATH'
+        ]);
+
+        const wildcard = preloadGen.generateMinimalEnv({ dotenv: { allowed: ['*'] } }, env);
+        assert.deepStrictEqual(wildcard, env);
+
+        // The public tier is kept; its patterns skip secret-looking names
+        const dir = fs.mkdtempSync(path.join(require('os').tmpdir(), 'dotnope-minimal-'));
+        const pkgPath = path.join(dir, 'package.json');
+        try {
+            fs.writeFileSync(pkgPath, JSON.stringify({
+                name: 'app',
+                environmentWhitelist: { __options__: { publicVars: ['APP_*'], autoPublicVars: true } }
+            }));
+            const publicEnv = { ...env, DEBUG: 'app:*', CI: 'true', APP_MODE: 'worker', APP_TOKEN: 't' };
+            const withPublic = preloadGen.generateMinimalEnv(config, publicEnv, {
+                publicVars: preloadGen.loadPublicVars(pkgPath)
+            });
+            for (const name of ['DEBUG', 'CI', 'APP_MODE', 'LOG_LEVEL']) {
+                assert.ok(name in withPublic, `should keep ${name}`);
+            }
+            assert.ok(!('APP_TOKEN' in withPublic));
+            assert.ok(!('AWS_SECRET_ACCESS_KEY' in withPublic));
+        } finally {
+            fs.rmSync(dir, { recursive: true, force: true });
+        }
+    });
+
+    test('should build a dotnope-launch command line', () => {
+        const preloadGen = require('../lib/preload-generator');
+        const os = require('os');
+        const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'dotnope-launch-'));
+        const pkgPath = path.join(dir, 'package.json');
+
+        try {
+            fs.writeFileSync(pkgPath, JSON.stringify({
+                name: 'app',
+                environmentWhitelist: { axios: { allowed: ['HTTP_PROXY'] } }
+            }));
+            const common = { launcher: '/opt/dotnope-launch', library: '/opt/libdotnope_preload.so' };
+
+            const argv = preloadGen.generateLaunchCommand(pkgPath, ['node', 'app.js'], { ...common, logFile: 'stderr' });
+            assert.deepStrictEqual(argv, [
+                '/opt/dotnope-launch', '-L', '/opt/libdotnope_preload.so',
+                '-P', 'HTTP_PROXY', '-l', 'stderr', '--', 'node', 'app.js'
+            ]);
+
+            const policyFile = path.join(dir, 'policy.bin');
+            const withFile = preloadGen.generateLaunchCommand(pkgPath, ['node'], { ...common, policyFile });
+            assert.deepStrictEqual(withFile.slice(3, 5), ['-p', policyFile]);
+            assert.deepStrictEqual(preloadGen.readCompiledPolicy(fs.readFileSync(policyFile)).vars, ['HTTP_PROXY']);
+        } finally {
+            fs.rmSync(dir, { recursive: true, force: true });
+        }
+    });
+
     test('should find preload library path', () => {
         const preloadGen = require('../lib/preload-generator');
 
@@ -427,3 +612,95 @@ describe('Preload Generator', () => {
         // May or may not exist depending on build state
     });
 });
+
+describe('Native Addon Patching', () => {
+    const PROBE_SOURCE = `#include <node_api.h>
+#include <stdlib.h>
+
+static napi_value Get(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value arg, result;
+    char name[256];
+    size_t length;
+    napi_get_cb_info(env, info, &argc, &arg, NULL, NULL);
+    napi_get_value_string_utf8(env, arg, name, sizeof(name), &length);
+    const char* value = getenv(name);
+    if (value) {
+        napi_create_string_utf8(env, value, NAPI_AUTO_LENGTH, &result);
+    } else {
+        napi_get_null(env, &result);
+    }
+    return result;
+}
+
+NAPI_MODULE_INIT() {
+    napi_value fn;
+    napi_create_function(env, "getenv", NAPI_AUTO_LENGTH, Get, NULL, &fn);
+    napi_set_named_property(env, exports, "getenv", fn);
+    return exports;
+}
+`;
+
+    test('should filter getenv calls made by a real .node addon', (t) => {
+        const nativeBridge = require('../lib/native-bridge');
+        const { spawnSync } = require('child_process');
+
+        const includeDir = path.join(process.execPath, '..', '..', 'include', 'node');
+        if (!nativeBridge.isNativeAvailable() || process.platform !== 'linux') {
+            t.skip('native addon not available');
+            return;
+        }
+        if (!fs.existsSync(path.join(includeDir, 'node_api.h'))) {
+            t.skip('Node headers not found');
+            return;
+        }
+
+        const fixturesDir = getUniqueFixturesDir();
+        try {
+            setupMockProject(fixturesDir, {
+                'native-probe': { allowed: ['PROBE_ALLOWED'] }
+            });
+
+            // A third-party addon that calls getenv() through its PLT
+            const probeDir = path.join(fixturesDir, 'node_modules', 'native-probe');
+            fs.mkdirSync(probeDir, { recursive: true });
+            fs.writeFileSync(path.join(probeDir, 'package.json'),
+                JSON.stringify({ name: 'native-probe', version: '1.0.0', main: 'probe.node' }));
+            fs.writeFileSync(path.join(probeDir, 'probe.c'), PROBE_SOURCE);
+            const build = spawnSync('cc', ['-shared', '-fPIC', '-I', includeDir,
+                '-o', path.join(probeDir, 'probe.node'), path.join(probeDir, 'probe.c')]);
+            if (build.error || build.status !== 0) {
+                t.skip('no C compiler to build the fixture addon');
+                return;
+            }
+
+            // Patching is process-wide, so run it in a child
+            fs.writeFileSync(path.join(fixturesDir, 'main.js'), `
+const dotnope = require(${JSON.stringify(path.join(__dirname, '..', 'index.js'))});
+const handle = dotnope.enableStrictEnv({ strictLoadOrder: false, suppressWarnings: true, patchNativeAddons: true });
+const probe = require('native-probe');
+console.log(JSON.stringify({
+    allowed: probe.getenv('PROBE_ALLOWED'),
+    secret: probe.getenv('PROBE_SECRET'),
+    stats: handle.getNativePatchStats()
+}));
+`);
+            const child = spawnSync(process.execPath, ['main.js'], {
+                cwd: fixturesDir,
+                env: { PATH: process.env.PATH, PROBE_ALLOWED: 'yes', PROBE_SECRET: 'topsecret' },
+                encoding: 'utf8'
+            });
+            assert.strictEqual(child.status, 0, child.stderr);
+
+            const result = JSON.parse(child.stdout.trim().split('\n').pop());
+            assert.strictEqual(result.allowed, 'yes');
+            assert.strictEqual(result.secret, null);
+
+            const stats = result.stats.find(entry => entry.path.endsWith('probe.node'));
+            assert.ok(stats && stats.slots > 0, 'getenv slot should be patched');
+            assert.ok(stats.denied >= 1);
+        } finally {
+            cleanup(fixturesDir);
+        }
+    });
+});
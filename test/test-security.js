@@ -403,6 +403,45 @@ describe('Security Tests', { concurrency: false }, () => {
             }
         });
 
+        test('should refresh filtered keys when the key set changes', () => {
+            const fixturesDir = getUniqueFixturesDir();
+            try {
+                const { mainPkgPath, fakePackageDir } = setupMockProject(fixturesDir, {
+                    'fake-package': {
+                        allowed: ['LATE_VAR'],
+                        canWrite: [],
+                        canDelete: []
+                    }
+                });
+
+                delete process.env.LATE_VAR;
+                process.chdir(fixturesDir);
+
+                const dotnope = require('../index');
+                const handle = dotnope.enableStrictEnv({
+                    strictLoadOrder: false,
+                    configPath: mainPkgPath,
+                    moduleScopedEnv: true
+                });
+
+                delete require.cache[require.resolve(fakePackageDir)];
+                const fakePackage = require(fakePackageDir);
+
+                assert.ok(!fakePackage.getAllKeys().includes('LATE_VAR'));
+
+                process.env.LATE_VAR = 'late';
+                assert.ok(fakePackage.getAllKeys().includes('LATE_VAR'), 'Should see a key added after caching');
+
+                delete process.env.LATE_VAR;
+                assert.ok(!fakePackage.getAllKeys().includes('LATE_VAR'), 'Should not see a deleted key');
+
+                const token = handle.getToken();
+                handle.disable(token);
+            } finally {
+                cleanup(fixturesDir);
+            }
+        });
+
         test('should return empty keys for non-whitelisted package', () => {
             const fixturesDir = getUniqueFixturesDir();
             try {
@@ -460,6 +499,203 @@ describe('Security Tests', { concurrency: false }, () => {
                 cleanup(fixturesDir);
             }
         });
+
+        test('should not let a package borrow the main app enumeration', () => {
+            const fixturesDir = getUniqueFixturesDir();
+            try {
+                const { mainPkgPath, fakePackageDir } = setupMockProject(fixturesDir, {
+                    '__options__': {
+                        denyMode: 'silent'
+                    },
+                    'fake-package': {
+                        allowed: [],
+                        canWrite: [],
+                        canDelete: []
+                    }
+                });
+
+                process.env.ENUM_SECRET = 'topsecret';
+                process.chdir(fixturesDir);
+
+                const dotnope = require('../index');
+                const handle = dotnope.enableStrictEnv({ strictLoadOrder: false, configPath: mainPkgPath });
+
+                delete require.cache[require.resolve(fakePackageDir)];
+                const fakePackage = require(fakePackageDir);
+
+                // The app enumerates; the package then reads the same keys
+                // in order within the same turn
+                const keys = [];
+                for (const key in process.env) {
+                    keys.push(key);
+                }
+                assert.ok(keys.includes('ENUM_SECRET'));
+                const leaked = keys.filter(key => fakePackage.getEnvVar(key) !== undefined);
+                assert.deepStrictEqual(leaked, [], 'Should not read the keys the app enumerated');
+
+                const token = handle.getToken();
+                handle.disable(token);
+            } finally {
+                cleanup(fixturesDir);
+            }
+        });
+
+        test('should not let a package borrow another package enumeration', () => {
+            const fixturesDir = getUniqueFixturesDir();
+            try {
+                // fake-package calls into config-lib's enumerations, then
+                // reads the enumerated keys itself within the same turn
+                const { mainPkgPath, fakePackageDir } = setupMockProject(fixturesDir, {
+                    '__options__': {
+                        denyMode: 'silent'
+                    },
+                    'fake-package': {
+                        allowed: []
+                    },
+                    'config-lib': {
+                        allowed: ['DB_PASSWORD']
+                    }
+                }, `'use strict';
+module.exports = function borrow(configDir) {
+    const config = require(configDir);
+    const read = [];
+    config.keys();
+    read.push(process.env.DB_PASSWORD);
+    for (const key of config.forIn()) {
+        read.push(process.env[key]);
+    }
+    config.ownKeys();
+    const descriptor = Object.getOwnPropertyDescriptor(process.env, 'DB_PASSWORD');
+    read.push(descriptor && descriptor.value);
+    config.ownKeys();
+    read.push(process.env.DB_PASSWORD);
+    return { own: config.spread(), read: read.filter(Boolean) };
+};`);
+
+                const configDir = path.join(fixturesDir, 'node_modules/config-lib');
+                fs.mkdirSync(configDir, { recursive: true });
+                fs.writeFileSync(path.join(configDir, 'package.json'),
+                    JSON.stringify({ name: 'config-lib', version: '1.0.0', main: 'index.js' }));
+                fs.writeFileSync(path.join(configDir, 'index.js'), `'use strict';
+exports.keys = () => Object.keys(process.env);
+exports.forIn = () => {
+    const keys = [];
+    for (const key in process.env) {
+        keys.push(key);
+    }
+    return keys;
+};
+exports.ownKeys = () => Reflect.ownKeys(process.env);
+exports.spread = () => ({ ...process.env });
+`);
+
+                process.env.DB_PASSWORD = 'hunter2';
+                process.chdir(fixturesDir);
+
+                const dotnope = require('../index');
+                const handle = dotnope.enableStrictEnv({ strictLoadOrder: false, configPath: mainPkgPath });
+
+                delete require.cache[require.resolve(fakePackageDir)];
+                const borrow = require(fakePackageDir);
+                const result = borrow(configDir);
+
+                // config-lib still sees its own variable through a single enumeration
+                assert.strictEqual(result.own.DB_PASSWORD, 'hunter2');
+                assert.deepStrictEqual(result.read, [], 'Should not read the keys config-lib enumerated');
+
+                const token = handle.getToken();
+                handle.disable(token);
+            } finally {
+                delete process.env.DB_PASSWORD;
+                cleanup(fixturesDir);
+            }
+        });
+    });
+
+    describe('Module-Scoped View Protection', () => {
+        test('should not leak a package view through replaced built-ins', () => {
+            const fixturesDir = getUniqueFixturesDir();
+            try {
+                // fake-package patches globals, then loads a trusted package
+                // to catch the view handed to it
+                const { mainPkgPath } = setupMockProject(fixturesDir, {
+                    '__options__': {
+                        denyMode: 'silent'
+                    },
+                    'fake-package': {
+                        allowed: []
+                    },
+                    'trusted-package': {
+                        allowed: ['TRUSTED_SECRET']
+                    }
+                }, `'use strict';
+const Module = require('module');
+module.exports = function steal(trustedDir) {
+    const views = [];
+    const keep = (value) => {
+        if (value && typeof value === 'object' && value.env) {
+            views.push(value);
+        }
+    };
+    const realDefine = Object.defineProperty;
+    const realSet = Map.prototype.set;
+    const realWrap = Module.wrap;
+    Object.defineProperty = function (obj, key, descriptor) {
+        keep(descriptor && descriptor.value);
+        return realDefine(obj, key, descriptor);
+    };
+    Map.prototype.set = function (key, value) {
+        keep(value);
+        return realSet.call(this, key, value);
+    };
+    Module.wrap = function (script) {
+        for (const cached of Object.values(require.cache)) {
+            keep(cached.__dotnopeProcess);
+        }
+        return realWrap(script);
+    };
+    try {
+        require(trustedDir);
+    } finally {
+        Object.defineProperty = realDefine;
+        Map.prototype.set = realSet;
+        Module.wrap = realWrap;
+    }
+    return {
+        own: process.env.TRUSTED_SECRET,
+        stolen: views.map(view => view.env.TRUSTED_SECRET).filter(Boolean)
+    };
+};`);
+
+                const trustedDir = path.join(fixturesDir, 'node_modules/trusted-package');
+                fs.mkdirSync(trustedDir, { recursive: true });
+                fs.writeFileSync(path.join(trustedDir, 'package.json'),
+                    JSON.stringify({ name: 'trusted-package', version: '1.0.0', main: 'index.js' }));
+                fs.writeFileSync(path.join(trustedDir, 'index.js'),
+                    "'use strict';\nmodule.exports = () => process.env.TRUSTED_SECRET;\n");
+
+                process.env.TRUSTED_SECRET = 'topsecret';
+                process.chdir(fixturesDir);
+
+                const dotnope = require('../index');
+                const handle = dotnope.enableStrictEnv({
+                    strictLoadOrder: false,
+                    configPath: mainPkgPath,
+                    moduleScopedEnv: true
+                });
+
+                const steal = require(path.join(fixturesDir, 'node_modules/fake-package'));
+                const result = steal(trustedDir);
+
+                assert.strictEqual(result.own, undefined);
+                assert.deepStrictEqual(result.stolen, []);
+
+                const token = handle.getToken();
+                handle.disable(token);
+            } finally {
+                cleanup(fixturesDir);
+            }
+        });
     });
 
     describe('Eval/Function Protection', () => {
@@ -609,6 +845,59 @@ describe('Security Tests', { concurrency: false }, () => {
         });
     });
 
+    describe('denyMode Option', () => {
+        test('should deny silently and deduplicate reports', () => {
+            const fixturesDir = getUniqueFixturesDir();
+            try {
+                const { mainPkgPath, fakePackageDir } = setupMockProject(fixturesDir, {
+                    '__options__': {
+                        denyMode: 'silent'
+                    },
+                    'fake-package': {
+                        allowed: ['VISIBLE_VAR'],
+                        canWrite: [],
+                        canDelete: []
+                    }
+                });
+
+                process.env.VISIBLE_VAR = 'visible';
+                process.env.SECRET = 'value';
+                process.chdir(fixturesDir);
+
+                const dotnope = require('../index');
+                const handle = dotnope.enableStrictEnv({
+                    strictLoadOrder: false,
+                    configPath: mainPkgPath,
+                    moduleScopedEnv: true
+                });
+
+                delete require.cache[require.resolve(fakePackageDir)];
+                const fakePackage = require(fakePackageDir);
+
+                assert.strictEqual(fakePackage.getEnvVar('VISIBLE_VAR'), 'visible');
+                for (let i = 0; i < 5; i++) {
+                    assert.strictEqual(fakePackage.getEnvVar('SECRET'), undefined);
+                }
+                fakePackage.setEnvVar('INJECTED', 'x');
+                assert.strictEqual(process.env.INJECTED, undefined);
+
+                const reports = handle.getDenialReports();
+                const read = reports.find(r => r.envVar === 'SECRET' && r.operation === 'read');
+                assert.strictEqual(read.count, 5);
+                assert.strictEqual(read.packageName, 'fake-package');
+                assert.strictEqual(read.code, 'ERR_DOTNOPE_UNAUTHORIZED');
+                assert.ok(read.message.includes('SECRET'));
+                assert.ok(reports.some(r => r.envVar === 'INJECTED' && r.operation === 'write'));
+                assert.strictEqual(handle.getDenialOverflow(), 0);
+
+                const token = handle.getToken();
+                handle.disable(token);
+            } finally {
+                cleanup(fixturesDir);
+            }
+        });
+    });
+
     describe('Error.prepareStackTrace Tampering', () => {
         test('should resist prepareStackTrace override', () => {
             const fixturesDir = getUniqueFixturesDir();